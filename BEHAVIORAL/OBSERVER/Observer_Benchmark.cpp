@@ -0,0 +1,189 @@
+// A stress test and a benchmark of the ObserverList of Observer_Conceptual_Example.cpp, with many threads notifying
+// while other threads attach and detach observers. The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 -pthread Observer_Benchmark.cpp -o Observer_Benchmark
+//     ./Observer_Benchmark [milliseconds per run]
+// The stress test exits with a non-zero status if it detects an error.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main observerExampleMain
+#include "Observer_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+// The observer counts its notifications, and counts as an error a notification that arrives after it was detached
+// and the list was synchronized. Every throwPeriod-th notification throws, if throwPeriod isn't 0.
+class CheckingObserver : public IObserver
+{
+public:
+    explicit CheckingObserver(const std::uint64_t throwPeriod = 0)
+        : m_throwPeriod(throwPeriod)
+    { }
+    void update(std::string) override
+    {
+        const std::uint64_t count = m_updateCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (m_detached.load(std::memory_order_relaxed))
+        {
+            s_errorCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_throwPeriod != 0 && count % m_throwPeriod == 0)
+        {
+            throw std::runtime_error("CheckingObserver: update failed");
+        }
+    }
+    void setDetached(const bool detached) { m_detached.store(detached, std::memory_order_relaxed); }
+    std::uint64_t updateCount() const { return m_updateCount.load(std::memory_order_relaxed); }
+    static std::uint64_t errorCount() { return s_errorCount.load(std::memory_order_relaxed); }
+
+private:
+    std::uint64_t m_throwPeriod;
+    std::atomic<std::uint64_t> m_updateCount = 0;
+    std::atomic<bool> m_detached = false;
+    static inline std::atomic<std::uint64_t> s_errorCount = 0;
+};
+
+// The baseline the ObserverList replaces: a list that readers and writers share under one mutex.
+class LockedObserverList
+{
+public:
+    void add(IObserver* const observer)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_observers.push_back(observer);
+    }
+    void remove(IObserver* const observer)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        std::erase(m_observers, observer);
+    }
+    template <typename Func>
+    void read(Func&& func) const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        func(m_observers);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<IObserver*> m_observers;
+};
+
+struct RunResult
+{
+    std::uint64_t notifications = 0;
+    std::uint64_t writes = 0;
+};
+
+// Readers notify all the observers in a loop, and writers attach and detach observers of their own, while the
+// list always keeps a few permanent observers. When checking, the writers also synchronize the list every now
+// and then, and check that the observer they detached isn't notified any more.
+template <typename List>
+RunResult run(const int readerCount, const int writerCount, const std::chrono::milliseconds duration,
+              const bool checking, const std::uint64_t throwPeriod = 0)
+{
+    List list;
+    std::vector<std::unique_ptr<CheckingObserver>> permanentObservers;
+    for (int i = 0; i < 8; ++i)
+    {
+        permanentObservers.push_back(std::make_unique<CheckingObserver>(throwPeriod));
+        list.add(permanentObservers.back().get());
+    }
+
+    std::atomic<bool> stopping = false;
+    std::atomic<std::uint64_t> notifications = 0;
+    std::atomic<std::uint64_t> writes = 0;
+    std::vector<std::thread> threads;
+    for (int reader = 0; reader < readerCount; ++reader)
+    {
+        threads.emplace_back([&list, &stopping, &notifications]
+        {
+            std::uint64_t count = 0;
+            while (!stopping.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    list.read([&count](const std::vector<IObserver*>& observers)
+                    {
+                        for (IObserver* const observer : observers)
+                        {
+                            observer->update("Tick");
+                            ++count;
+                        }
+                    });
+                }
+                catch (const std::runtime_error&)
+                {
+                }
+            }
+            notifications.fetch_add(count);
+        });
+    }
+    for (int writer = 0; writer < writerCount; ++writer)
+    {
+        threads.emplace_back([&list, &stopping, &writes, checking]
+        {
+            std::array<CheckingObserver, 4> observers;
+            std::uint64_t count = 0;
+            while (!stopping.load(std::memory_order_relaxed))
+            {
+                CheckingObserver& observer = observers[count % observers.size()];
+                observer.setDetached(false);
+                list.add(&observer);
+                list.remove(&observer);
+                if constexpr (std::is_same_v<List, ObserverList>)
+                {
+                    if (checking && count % 64 == 0)
+                    {
+                        list.synchronize();
+                        observer.setDetached(true);
+                    }
+                }
+                ++count;
+            }
+            writes.fetch_add(count);
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stopping.store(true);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    return RunResult{ notifications.load(), writes.load() };
+}
+
+int main(int argc, char* argv[])
+{
+    const std::chrono::milliseconds duration(argc > 1 ? std::atoi(argv[1]) : 200);
+    const double seconds = std::chrono::duration<double>(duration).count();
+
+    std::cout << "Stress test: 4 readers, 4 writers, observers that throw on every 1000th notification.\n";
+    run<ObserverList>(4, 4, duration, true, 1000);
+    if (CheckingObserver::errorCount() != 0)
+    {
+        std::cout << "FAILED: " << CheckingObserver::errorCount() << " notifications after synchronize().\n";
+        return 1;
+    }
+    std::cout << "Passed.\n\n";
+
+    std::cout << "readers  writers  list          notifications/s  attach+detach/s\n";
+    for (const int readerCount : { 1, 2, 4, 8 })
+    {
+        for (const int writerCount : { 1, 4 })
+        {
+            const RunResult copyOnWrite = run<ObserverList>(readerCount, writerCount, duration, false);
+            const RunResult locked = run<LockedObserverList>(readerCount, writerCount, duration, false);
+            for (const auto& [name, result] : { std::pair{ "copy-on-write", copyOnWrite }, std::pair{ "mutex        ", locked } })
+            {
+                std::cout << readerCount << "        " << writerCount << "        " << name << "  "
+                          << static_cast<std::uint64_t>(result.notifications / seconds) << "        "
+                          << static_cast<std::uint64_t>(result.writes / seconds) << '\n';
+            }
+        }
+    }
+}
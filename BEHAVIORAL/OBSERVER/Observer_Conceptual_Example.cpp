@@ -4,8 +4,15 @@
 // with this pattern. Just remember that the Subject is also called the Publisher and the Observer is often
 // called the Subscriber and vice versa. Also the verbs "observe", "listen" or "track" usually mean the same thing.
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
-#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class IObserver // ISubscriber
 {
@@ -31,7 +38,176 @@ public:
     virtual void notify() = 0;
 };
 
+// The ObserverList is a copy-on-write (RCU-style) container of observers. Readers never lock: they register in
+// the current epoch, load the published immutable snapshot and iterate it. Writers copy the snapshot, modify the
+// copy and publish it atomically. They never wait for readers: the replaced snapshot is retired with the epoch in
+// which it was replaced, and freed by a later write or read once no reader of that epoch is left.
+class ObserverList
+{
+private:
+    using Snapshot = std::vector<IObserver*>;
+    struct Retired
+    {
+        const Snapshot* snapshot;
+        std::uint64_t epoch;
+    };
+
+    std::atomic<const Snapshot*> m_snapshot;
+    // The epoch only advances once every reader of the epoch before the current one has left, so two reader
+    // counters, used alternately, are enough.
+    mutable std::atomic<std::uint64_t> m_epoch;
+    mutable std::array<std::atomic<std::uint64_t>, 2> m_readers;
+    // Writers are rare, so they are serialized by a mutex, which also guards the retired snapshots. Readers only
+    // try to take it, to free the retired snapshots, and never wait for it.
+    mutable std::mutex m_writeMutex;
+    mutable std::vector<Retired> m_retired;
+    mutable std::atomic<bool> m_hasRetired;
+
+    // Registers the calling reader in the current epoch and returns that epoch. The epoch is re-checked
+    // after the registration, so a writer that advances the epoch concurrently can't miss this reader.
+    std::uint64_t enterRead() const
+    {
+        for (;;)
+        {
+            const std::uint64_t epoch = m_epoch.load();
+            m_readers[epoch & 1].fetch_add(1);
+            if (m_epoch.load() == epoch)
+            {
+                return epoch;
+            }
+            m_readers[epoch & 1].fetch_sub(1);
+        }
+    }
+    void exitRead(const std::uint64_t epoch) const
+    {
+        m_readers[epoch & 1].fetch_sub(1);
+        if (m_hasRetired.load(std::memory_order_relaxed))
+        {
+            const std::unique_lock<std::mutex> lock(m_writeMutex, std::try_to_lock);
+            if (lock.owns_lock())
+            {
+                reclaim();
+            }
+        }
+    }
+    // Keeps the reader registered for its lifetime, so that a read that throws still leaves its epoch.
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(const ObserverList& list)
+            : m_list(list)
+            , m_epoch(list.enterRead())
+        { }
+        ~ReadGuard() { m_list.exitRead(m_epoch); }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        const ObserverList& m_list;
+        std::uint64_t m_epoch;
+    };
+
+    // If every reader of the previous epoch has left, no reader can see the snapshots retired up to that epoch any
+    // more: they are freed and the epoch advances. This is tried twice, so that a snapshot retired in the current
+    // epoch is freed right away when there are no readers at all. Must be called with m_writeMutex held.
+    void reclaim() const
+    {
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            const std::uint64_t epoch = m_epoch.load();
+            if (m_readers[(epoch - 1) & 1].load() != 0)
+            {
+                break;
+            }
+            std::erase_if(m_retired, [epoch](const Retired& retired)
+            {
+                if (retired.epoch >= epoch)
+                {
+                    return false;
+                }
+                delete retired.snapshot;
+                return true;
+            });
+            m_epoch.store(epoch + 1);
+        }
+        m_hasRetired.store(!m_retired.empty());
+    }
+    // Publishes a new snapshot and retires the old one. Must be called with m_writeMutex held.
+    void publish(const Snapshot* const snapshot)
+    {
+        m_retired.push_back(Retired{ m_snapshot.exchange(snapshot), m_epoch.load() });
+        reclaim();
+    }
+
+public:
+    explicit ObserverList()
+        : m_snapshot(new Snapshot)
+        , m_epoch(1)
+        , m_readers{}
+        , m_hasRetired(false)
+    { }
+    ~ObserverList()
+    {
+        for (const Retired& retired : m_retired)
+        {
+            delete retired.snapshot;
+        }
+        delete m_snapshot.load();
+    }
+    ObserverList(const ObserverList&) = delete;
+    ObserverList& operator=(const ObserverList&) = delete;
+
+    // Observers may also be added and removed by observers during a notification.
+    void add(IObserver* const observer)
+    {
+        const std::lock_guard<std::mutex> lock(m_writeMutex);
+        Snapshot* const snapshot = new Snapshot(*m_snapshot.load());
+        snapshot->push_back(observer);
+        publish(snapshot);
+    }
+    void remove(IObserver* const observer)
+    {
+        const std::lock_guard<std::mutex> lock(m_writeMutex);
+        Snapshot* const snapshot = new Snapshot(*m_snapshot.load());
+        std::erase(*snapshot, observer);
+        publish(snapshot);
+    }
+
+    // Calls func with the snapshot that was current when the read started. An observer removed concurrently
+    // may still receive notifications from reads that started before remove() returned.
+    template <typename Func>
+    void read(Func&& func) const
+    {
+        const ReadGuard guard(*this);
+        func(*m_snapshot.load());
+    }
+
+    // Waits until every read that started before the call has finished, so that a removed observer can be deleted.
+    // Unlike add() and remove(), it must not be called during a read, since it would wait for that read.
+    void synchronize() const
+    {
+        const std::uint64_t target = m_epoch.load() + 2;
+        for (;;)
+        {
+            {
+                const std::lock_guard<std::mutex> lock(m_writeMutex);
+                if (m_epoch.load() >= target)
+                {
+                    return;
+                }
+                reclaim();
+                if (m_epoch.load() >= target)
+                {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+};
+
 // The Subject owns some important state and notifies observers when the state changes.
+// Observers may be attached and detached from other threads while notify() is running.
 class Subject : public ISubject
 {
 public:
@@ -39,17 +215,26 @@ public:
     ~Subject() override { std::cout << "Goodbye, I was the Subject.\n"; }
 
     // The subscription management methods.
-    void attach(IObserver* observer) override { m_observers.push_back(observer); }
+    void attach(IObserver* observer) override { m_observers.add(observer); }
     void detach(IObserver* observer) override { m_observers.remove(observer); }
+    // A detached observer may still be notified by a notify() that was already running. It can be deleted
+    // once this has returned.
+    void waitForNotifications() const { m_observers.synchronize(); }
 
-    void howManyObservers() const { std::cout << "There are " << m_observers.size() << " observers in the list.\n"; }
+    void howManyObservers() const
+    {
+        m_observers.read([](const std::vector<IObserver*>& observers) { printObserverCount(observers); });
+    }
     void notify() override
     {
-        howManyObservers();
-        for (IObserver* const observer : m_observers)
+        m_observers.read([this](const std::vector<IObserver*>& observers)
         {
-            observer->update(m_message);
-        }
+            printObserverCount(observers);
+            for (IObserver* const observer : observers)
+            {
+                observer->update(m_message);
+            }
+        });
     }
     void createMessage(std::string message = "Empty")
     {
@@ -67,7 +252,12 @@ public:
     }
 
 private:
-    std::list<IObserver*> m_observers;
+    static void printObserverCount(const std::vector<IObserver*>& observers)
+    {
+        std::cout << "There are " << observers.size() << " observers in the list.\n";
+    }
+
+    ObserverList m_observers;
     std::string m_message;
 };
 
@@ -103,6 +293,166 @@ private:
 
 int Observer::staticNumber = 0;
 
+// The ConflatingObserver decorates a (possibly slow) observer, so that it is notified at its own pace instead of
+// at the Subject's update rate. Each update overwrites a single pending slot and a worker thread delivers whatever
+// is in the slot when the wrapped observer is ready again. So the wrapped observer is woken at most once per
+// delivery and always gets the newest message. The overwritten messages are counted as conflated.
+class ConflatingObserver : public IObserver
+{
+public:
+    explicit ConflatingObserver(IObserver& observer)
+        : m_observer(observer)
+        , m_hasPending(false)
+        , m_stopping(false)
+        , m_conflatedCount(0)
+        , m_worker([this] { deliver(); })
+    { }
+    // The pending message, if any, is delivered before the worker stops.
+    ~ConflatingObserver() override
+    {
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wakeUp.notify_one();
+        m_worker.join();
+    }
+    void update(std::string messageFromSubject) override
+    {
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_hasPending)
+            {
+                m_conflatedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_pending = std::move(messageFromSubject);
+            m_hasPending = true;
+        }
+        m_wakeUp.notify_one();
+    }
+    // The number of messages that were overwritten before the wrapped observer could see them.
+    std::uint64_t conflatedCount() const { return m_conflatedCount.load(std::memory_order_relaxed); }
+
+private:
+    void deliver()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wakeUp.wait(lock, [this] { return m_hasPending || m_stopping; });
+            if (!m_hasPending)
+            {
+                return;
+            }
+            std::string message = std::move(m_pending);
+            m_hasPending = false;
+            lock.unlock();
+            m_observer.update(std::move(message));
+            lock.lock();
+        }
+    }
+
+    IObserver& m_observer;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::string m_pending;
+    bool m_hasPending;
+    bool m_stopping;
+    std::atomic<std::uint64_t> m_conflatedCount;
+    // The worker is declared last, so that it starts after all the other members are initialized.
+    std::thread m_worker;
+};
+
+// The OneShotObserver wants a single notification, so it detaches itself from inside its update().
+class OneShotObserver : public IObserver
+{
+public:
+    explicit OneShotObserver(ObserverList& observers)
+        : m_observers(observers)
+        , m_updateCount(0)
+    {
+        m_observers.add(this);
+    }
+    void update(std::string) override
+    {
+        m_updateCount.fetch_add(1, std::memory_order_relaxed);
+        m_observers.remove(this);
+    }
+    std::uint64_t updateCount() const { return m_updateCount.load(std::memory_order_relaxed); }
+
+private:
+    ObserverList& m_observers;
+    std::atomic<std::uint64_t> m_updateCount;
+};
+
+// Notifications run on several threads while other threads attach and detach observers, and the one-shot
+// observers detach themselves during the notifications. Neither side waits for the other.
+void concurrentClientCode()
+{
+    ObserverList observers;
+    std::vector<std::unique_ptr<OneShotObserver>> oneShotObservers;
+    for (int i = 0; i < 100; ++i)
+    {
+        oneShotObservers.push_back(std::make_unique<OneShotObserver>(observers));
+    }
+
+    // These observers are only attached and detached again by a writer thread.
+    struct SilentObserver : public IObserver
+    {
+        void update(std::string) override {}
+    };
+    std::array<SilentObserver, 4> silentObservers;
+
+    std::atomic<bool> stopping = false;
+    const auto notifyAll = [&observers, &stopping]
+    {
+        while (!stopping.load())
+        {
+            observers.read([](const std::vector<IObserver*>& snapshot)
+            {
+                for (IObserver* const observer : snapshot)
+                {
+                    observer->update("Ping");
+                }
+            });
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i)
+    {
+        threads.emplace_back(notifyAll);
+    }
+    std::thread writer([&observers, &silentObservers]
+    {
+        for (std::size_t round = 0; round < 1000; ++round)
+        {
+            SilentObserver& observer = silentObservers[round % silentObservers.size()];
+            observers.add(&observer);
+            observers.remove(&observer);
+        }
+    });
+    writer.join();
+    // Every one-shot observer gets notified at least once, and then it's gone.
+    for (bool done = false; !done; std::this_thread::yield())
+    {
+        observers.read([&done](const std::vector<IObserver*>& snapshot) { done = snapshot.empty(); });
+    }
+    stopping.store(true);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    observers.synchronize();
+
+    std::size_t notifiedCount = 0;
+    for (const std::unique_ptr<OneShotObserver>& observer : oneShotObservers)
+    {
+        notifiedCount += observer->updateCount() != 0 ? 1 : 0;
+    }
+    std::cout << "Concurrent run: " << notifiedCount << " of " << oneShotObservers.size()
+              << " one-shot observers were notified and detached themselves.\n";
+}
+
 int main()
 {
     Subject* const subject = new Subject;
@@ -125,6 +475,20 @@ int main()
     observer4->removeMeFromTheList();
     observer1->removeMeFromTheList();
 
+    // A slow observer can be attached through the conflating decorator to see only the newest of the high-rate updates.
+    ConflatingObserver* const conflatingObserver1 = new ConflatingObserver(*observer1);
+    subject->attach(conflatingObserver1);
+    for (int tick = 1; tick <= 5; ++tick)
+    {
+        subject->createMessage("Tick " + std::to_string(tick));
+    }
+    subject->detach(conflatingObserver1);
+    std::cout << "Conflated messages: " << conflatingObserver1->conflatedCount() << "\n";
+    delete conflatingObserver1;
+
+    concurrentClientCode();
+
+    subject->waitForNotifications();
     delete observer5;
     delete observer4;
     delete observer3;
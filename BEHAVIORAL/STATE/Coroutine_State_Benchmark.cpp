@@ -0,0 +1,89 @@
+// A run of a million AsyncContexts of Coroutine_State_Conceptual_Example.cpp on one Scheduler: it reports the memory
+// that an idle Context costs, checks that a full Context pushes back on post(), and times the events that every
+// Context handles, including a timer wait. The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 Coroutine_State_Benchmark.cpp -o Coroutine_State_Benchmark
+//     ./Coroutine_State_Benchmark [context count]
+// The handlers print every step, so std::cout is silenced while the Contexts run.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main coroutineStateExampleMain
+#include "Coroutine_State_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+
+// The resident set size of the process, from /proc/self/statm.
+std::size_t residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    std::size_t totalPages = 0;
+    std::size_t residentPages = 0;
+    statm >> totalPages >> residentPages;
+    return residentPages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+template <typename Func>
+double secondsOf(Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t contextCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    std::cout.setstate(std::ios::badbit);
+
+    Scheduler scheduler;
+    std::vector<std::unique_ptr<AsyncContext>> contexts;
+    contexts.reserve(contextCount);
+    const std::size_t residentBefore = residentBytes();
+    const double createSeconds = secondsOf([&]
+    {
+        for (std::size_t i = 0; i < contextCount; ++i)
+        {
+            // No handler posted below waits on its input, so the Contexts can share an invalid descriptor.
+            contexts.push_back(std::make_unique<AsyncContext>(scheduler, AsyncStateA::instance(), -1));
+        }
+    });
+    const std::size_t residentIdle = residentBytes();
+
+    // A Context takes EVENT_CAPACITY events before its coroutine runs, and refuses the next one.
+    bool pushedBack = true;
+    for (std::size_t i = 0; i < AsyncContext::EVENT_CAPACITY; ++i)
+    {
+        pushedBack = pushedBack && contexts.front()->post(Event::REQUEST_2);
+    }
+    pushedBack = pushedBack && !contexts.front()->post(Event::REQUEST_2);
+    scheduler.run();
+
+    // Every Context handles a request that returns at once, and then one that waits for a timer and transitions.
+    std::size_t dropped = 0;
+    const double eventSeconds = secondsOf([&]
+    {
+        for (const std::unique_ptr<AsyncContext>& context : contexts)
+        {
+            dropped += !context->post(Event::REQUEST_2);
+            dropped += !context->post(Event::REQUEST_1);
+        }
+        scheduler.run();
+    });
+    std::cout.clear();
+
+    if (!pushedBack || dropped != 0)
+    {
+        std::cout << "FAILED: post() didn't respect the capacity of " << int(AsyncContext::EVENT_CAPACITY)
+                  << " events, " << dropped << " events were dropped.\n";
+        return 1;
+    }
+    std::cout << contextCount << " contexts created in " << createSeconds << " s\n"
+              << "Resident memory per idle context: " << (residentIdle - residentBefore) / double(contextCount)
+              << " B (sizeof(AsyncContext) is " << sizeof(AsyncContext) << " B)\n"
+              << 2 * contextCount << " events handled in " << eventSeconds << " s, including a 10 ms timer per context: "
+              << static_cast<std::uint64_t>(2 * contextCount / eventSeconds) << " events/s\n";
+}
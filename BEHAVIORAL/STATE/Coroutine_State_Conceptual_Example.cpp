@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// When the State handlers wait on timers or I/O, a synchronous State interface needs one blocked thread per Context.
+// Here the handlers are C++20 coroutines instead: a handler can co_await the next event, a timer or the readiness
+// of a file descriptor, and every suspended Context costs only its coroutine frame. All the Contexts are resumed
+// by a single-threaded Scheduler built on top of epoll.
+
+// The Task is a lazily started coroutine. Awaiting a Task starts it and resumes the awaiting coroutine when it ends.
+class Task
+{
+public:
+    struct promise_type
+    {
+        std::coroutine_handle<> m_continuation = std::noop_coroutine();
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept
+        {
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    return handle.promise().m_continuation;
+                }
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    { }
+    Task(Task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    { }
+    Task& operator=(Task&&) = delete;
+    ~Task()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> m_handle;
+
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+            {
+                m_handle.promise().m_continuation = continuation;
+                return m_handle;
+            }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{ m_handle };
+    }
+    // Starts a top level task, which nobody awaits.
+    void start() { m_handle.resume(); }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// The Scheduler resumes the coroutines that are ready to run, and sleeps in epoll_wait until the next
+// timer expires or one of the awaited file descriptors becomes ready.
+class Scheduler
+{
+private:
+    using Clock = std::chrono::steady_clock;
+    using Timer = std::pair<Clock::time_point, std::coroutine_handle<>>;
+
+    int m_epollFd;
+    std::vector<std::coroutine_handle<>> m_ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    std::size_t m_fdWaiters;
+
+    void fireExpiredTimers()
+    {
+        const Clock::time_point now = Clock::now();
+        while (!m_timers.empty() && m_timers.top().first <= now)
+        {
+            m_ready.push_back(m_timers.top().second);
+            m_timers.pop();
+        }
+    }
+    void pollFds(const int timeoutMs)
+    {
+        std::array<epoll_event, 64> events;
+        const int count = epoll_wait(m_epollFd, events.data(), static_cast<int>(events.size()), timeoutMs);
+        for (int i = 0; i < count; ++i)
+        {
+            m_ready.push_back(std::coroutine_handle<>::from_address(events[i].data.ptr));
+        }
+    }
+
+public:
+    explicit Scheduler()
+        : m_epollFd(epoll_create1(EPOLL_CLOEXEC))
+        , m_fdWaiters(0)
+    {
+        if (m_epollFd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+    }
+    ~Scheduler() { close(m_epollFd); }
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    void schedule(const std::coroutine_handle<> handle) { m_ready.push_back(handle); }
+
+    auto sleepFor(const std::chrono::milliseconds duration)
+    {
+        struct Awaiter
+        {
+            Scheduler& m_scheduler;
+            Clock::time_point m_deadline;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(const std::coroutine_handle<> handle) { m_scheduler.m_timers.emplace(m_deadline, handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ *this, Clock::now() + duration };
+    }
+
+    // Only one coroutine may wait on a given file descriptor at a time.
+    auto readable(const int fd)
+    {
+        struct Awaiter
+        {
+            Scheduler& m_scheduler;
+            int m_fd;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(const std::coroutine_handle<> handle)
+            {
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLONESHOT;
+                event.data.ptr = handle.address();
+                if (epoll_ctl(m_scheduler.m_epollFd, EPOLL_CTL_ADD, m_fd, &event) < 0)
+                {
+                    throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+                }
+                ++m_scheduler.m_fdWaiters;
+            }
+            void await_resume() const
+            {
+                epoll_ctl(m_scheduler.m_epollFd, EPOLL_CTL_DEL, m_fd, nullptr);
+                --m_scheduler.m_fdWaiters;
+            }
+        };
+        return Awaiter{ *this, fd };
+    }
+
+    // Runs until no coroutine is ready and nothing is awaited on timers or file descriptors any more.
+    // Coroutines suspended on events that nobody posts stay suspended.
+    void run()
+    {
+        std::vector<std::coroutine_handle<>> running;
+        while (!m_ready.empty() || !m_timers.empty() || m_fdWaiters != 0)
+        {
+            running.swap(m_ready);
+            for (const std::coroutine_handle<> handle : running)
+            {
+                handle.resume();
+            }
+            running.clear();
+
+            fireExpiredTimers();
+            if (!m_ready.empty())
+            {
+                pollFds(0);
+                continue;
+            }
+            int timeoutMs = -1;
+            if (!m_timers.empty())
+            {
+                const auto untilNext = std::chrono::ceil<std::chrono::milliseconds>(m_timers.top().first - Clock::now());
+                timeoutMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(untilNext.count(), 0));
+            }
+            else if (m_fdWaiters == 0)
+            {
+                break;
+            }
+            pollFds(timeoutMs);
+            fireExpiredTimers();
+        }
+    }
+};
+
+enum class Event : std::uint8_t
+{
+    REQUEST_1,
+    REQUEST_2
+};
+
+class AsyncContext;
+
+// The base State class declares the handlers as coroutines. The States are stateless and shared by all
+// Contexts, so the Context is passed as a parameter instead of being kept as a backreference.
+class AsyncState
+{
+public:
+    virtual ~AsyncState() = default;
+    virtual const char* name() const = 0;
+    virtual Task handle1(AsyncContext& context) const = 0;
+    virtual Task handle2(AsyncContext& context) const = 0;
+};
+
+// The Context runs one long-lived coroutine, which waits for the next posted event and lets the current
+// State handle it. While it waits, the Context holds no thread and its frame is its only extra memory.
+// The pending events are kept in a small ring buffer inside the Context, so an idle Context allocates nothing
+// for them, and a Context that falls behind pushes back on the poster instead of queueing without limit.
+class AsyncContext
+{
+public:
+    static constexpr std::uint8_t EVENT_CAPACITY = 4;
+
+private:
+    Scheduler& m_scheduler;
+    const AsyncState* m_state;
+    int m_inputFd;
+    std::array<Event, EVENT_CAPACITY> m_pendingEvents;
+    std::uint8_t m_firstPending;
+    std::uint8_t m_pendingCount;
+    std::coroutine_handle<> m_waitingForEvent;
+    Task m_loop;
+
+    auto nextEvent()
+    {
+        struct Awaiter
+        {
+            AsyncContext& m_context;
+
+            bool await_ready() const noexcept { return m_context.m_pendingCount != 0; }
+            void await_suspend(const std::coroutine_handle<> handle) noexcept { m_context.m_waitingForEvent = handle; }
+            Event await_resume() const noexcept
+            {
+                const Event event = m_context.m_pendingEvents[m_context.m_firstPending];
+                m_context.m_firstPending = (m_context.m_firstPending + 1) % EVENT_CAPACITY;
+                --m_context.m_pendingCount;
+                return event;
+            }
+        };
+        return Awaiter{ *this };
+    }
+    Task loop()
+    {
+        for (;;)
+        {
+            const Event event = co_await nextEvent();
+            if (event == Event::REQUEST_1)
+            {
+                co_await m_state->handle1(*this);
+            }
+            else
+            {
+                co_await m_state->handle2(*this);
+            }
+        }
+    }
+
+public:
+    explicit AsyncContext(Scheduler& scheduler, const AsyncState& state, const int inputFd)
+        : m_scheduler(scheduler)
+        , m_state(nullptr)
+        , m_inputFd(inputFd)
+        , m_pendingEvents{}
+        , m_firstPending(0)
+        , m_pendingCount(0)
+        , m_loop(loop())
+    {
+        transitionTo(state);
+        m_loop.start();
+    }
+    AsyncContext(const AsyncContext&) = delete;
+    AsyncContext& operator=(const AsyncContext&) = delete;
+
+    Scheduler& scheduler() const { return m_scheduler; }
+    int inputFd() const { return m_inputFd; }
+
+    void transitionTo(const AsyncState& state)
+    {
+        std::cout << "AsyncContext: Transition to " << state.name() << ".\n";
+        m_state = &state;
+    }
+    // Events are handled one at a time, in the order they were posted. Returns false, and drops the event, if
+    // EVENT_CAPACITY events are already pending; the poster can retry after the scheduler has run.
+    [[nodiscard]] bool post(const Event event)
+    {
+        if (m_pendingCount == EVENT_CAPACITY)
+        {
+            return false;
+        }
+        m_pendingEvents[(m_firstPending + m_pendingCount) % EVENT_CAPACITY] = event;
+        ++m_pendingCount;
+        if (m_waitingForEvent)
+        {
+            m_scheduler.schedule(std::exchange(m_waitingForEvent, nullptr));
+        }
+        return true;
+    }
+};
+
+// Concrete States implement various behaviors, associated with a state of the Context.
+class AsyncStateA : public AsyncState
+{
+public:
+    static const AsyncStateA& instance()
+    {
+        static const AsyncStateA state;
+        return state;
+    }
+    const char* name() const override { return "AsyncStateA"; }
+    Task handle1(AsyncContext& context) const override;
+    Task handle2(AsyncContext&) const override
+    {
+        std::cout << "AsyncStateA handles request2.\n";
+        co_return;
+    }
+};
+
+class AsyncStateB : public AsyncState
+{
+public:
+    static const AsyncStateB& instance()
+    {
+        static const AsyncStateB state;
+        return state;
+    }
+    const char* name() const override { return "AsyncStateB"; }
+    Task handle1(AsyncContext&) const override
+    {
+        std::cout << "AsyncStateB handles request1.\n";
+        co_return;
+    }
+    Task handle2(AsyncContext& context) const override
+    {
+        std::cout << "AsyncStateB handles request2 and waits for its input.\n";
+        co_await context.scheduler().readable(context.inputFd());
+        char input;
+        if (read(context.inputFd(), &input, 1) == 1)
+        {
+            std::cout << "AsyncStateB got '" << input << "' and wants to change the state of the context.\n";
+            context.transitionTo(AsyncStateA::instance());
+        }
+    }
+};
+
+Task AsyncStateA::handle1(AsyncContext& context) const
+{
+    std::cout << "AsyncStateA handles request1 and waits for a timer.\n";
+    co_await context.scheduler().sleepFor(std::chrono::milliseconds(10));
+    std::cout << "AsyncStateA wants to change the state of the context.\n";
+    context.transitionTo(AsyncStateB::instance());
+}
+
+int main()
+{
+    std::array<int, 2> pipeFds;
+    if (pipe(pipeFds.data()) < 0)
+    {
+        return 1;
+    }
+
+    Scheduler scheduler;
+    AsyncContext context(scheduler, AsyncStateA::instance(), pipeFds[0]);
+    std::cout << '\n';
+    if (!context.post(Event::REQUEST_1) || !context.post(Event::REQUEST_2) || write(pipeFds[1], "x", 1) != 1)
+    {
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        return 1;
+    }
+    scheduler.run();
+
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+}
@@ -0,0 +1,76 @@
+// A benchmark of the transitions per second of the state machines of State_Conceptual_Example.cpp: the classic
+// Context that allocates a new state on every transition, the VariantContext, and the ContextBatch stepped through
+// the transition table. The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 State_Benchmark.cpp -o State_Benchmark
+//     ./State_Benchmark [transitions per run]
+// The machines print every transition, so std::cout is silenced while they run; the formatting of the messages
+// is skipped, but the calls that make them, like typeid().name(), are still made.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main stateExampleMain
+#include "State_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <cstdlib>
+
+template <typename Func>
+double transitionsPerSecond(const std::size_t transitions, Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return transitions / elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t transitions = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    // Every pair of requests makes two transitions, A -> B -> A.
+    const std::size_t rounds = transitions / 2;
+
+    std::cout.setstate(std::ios::badbit);
+    const double classic = transitionsPerSecond(transitions, [rounds]
+    {
+        Context context(new ConcreteStateA);
+        for (std::size_t i = 0; i < rounds; ++i)
+        {
+            context.request1();
+            context.request2();
+        }
+    });
+    const double variant = transitionsPerSecond(transitions, [rounds]
+    {
+        VariantContext context;
+        for (std::size_t i = 0; i < rounds; ++i)
+        {
+            context.request1();
+            context.request2();
+        }
+    });
+    std::cout.clear();
+
+    // The batch makes the same number of transitions, spread over many contexts.
+    constexpr std::size_t BATCH_SIZE = 1'000'000;
+    const std::size_t eventCount = std::max<std::size_t>(transitions / BATCH_SIZE, 2) & ~std::size_t(1);
+    std::vector<Event> events;
+    for (std::size_t i = 0; i < eventCount; i += 2)
+    {
+        events.push_back(Event::REQUEST_1);
+        events.push_back(Event::REQUEST_2);
+    }
+    ContextBatch batch(BATCH_SIZE);
+    const double batched = transitionsPerSecond(BATCH_SIZE * eventCount, [&batch, &events] { batch.apply(events); });
+    if (batch.countIn(VariantTransitionTable::indexOf<VariantStateA>()) != BATCH_SIZE)
+    {
+        std::cout << "FAILED: the batch didn't return to VariantStateA.\n";
+        return 1;
+    }
+
+    std::cout << "context          transitions/s\n"
+              << "Context          " << static_cast<std::uint64_t>(classic) << '\n'
+              << "VariantContext   " << static_cast<std::uint64_t>(variant) << '\n'
+              << "ContextBatch     " << static_cast<std::uint64_t>(batched) << '\n';
+}
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <span>
+#include <variant>
+#include <vector>
 
 class Context;
 // The base State class declares methods that all Concrete State should implement
@@ -73,6 +80,137 @@ void ConcreteStateA::handle1()
     m_context->transitionTo(new ConcreteStateB);
 }
 
+// The same state machine can be made allocation-free when the set of states is closed. The Context then holds its
+// current state by value in a std::variant, so a transition is just a change of the active alternative: no heap
+// traffic, no RTTI and no virtual calls. The states are stateless and get the Context as a parameter instead of
+// keeping a backreference to it. Each state also declares the state that every request leads to, which lets
+// the transitions be tabulated at compile time (see TransitionTable below).
+class VariantContext;
+class VariantStateB;
+
+class VariantStateA
+{
+public:
+    static constexpr const char* name = "VariantStateA";
+    using OnRequest1 = VariantStateB;
+    using OnRequest2 = VariantStateA;
+    void handle1(VariantContext& context) const;
+    void handle2(VariantContext&) const { std::cout << "VariantStateA handles request2.\n"; }
+};
+
+class VariantStateB
+{
+public:
+    static constexpr const char* name = "VariantStateB";
+    using OnRequest1 = VariantStateB;
+    using OnRequest2 = VariantStateA;
+    void handle1(VariantContext&) const { std::cout << "VariantStateB handles request1.\n"; }
+    void handle2(VariantContext& context) const;
+};
+
+using VariantState = std::variant<VariantStateA, VariantStateB>;
+
+class VariantContext
+{
+private:
+    VariantState m_state;
+
+public:
+    explicit VariantContext() { transitionTo<VariantStateA>(); }
+
+    template <typename StateT>
+    void transitionTo()
+    {
+        std::cout << "VariantContext: Transition to " << StateT::name << ".\n";
+        m_state.emplace<StateT>();
+    }
+
+    // A single jump-table dispatch on the active state replaces the virtual call.
+    void request1() { std::visit([this](const auto& state) { state.handle1(*this); }, m_state); }
+    void request2() { std::visit([this](const auto& state) { state.handle2(*this); }, m_state); }
+};
+
+void VariantStateA::handle1(VariantContext& context) const
+{
+    std::cout << "VariantStateA handles request1.\n";
+    std::cout << "VariantStateA wants to change the state of the context.\n";
+    context.transitionTo<OnRequest1>();
+}
+
+void VariantStateB::handle2(VariantContext& context) const
+{
+    std::cout << "VariantStateB handles request2.\n";
+    std::cout << "VariantStateB wants to change the state of the context.\n";
+    context.transitionTo<OnRequest2>();
+}
+
+// When millions of independent contexts are stepped by the same events, the per-context objects and the scattered
+// calls can be replaced by a table. The TransitionTable is generated at compile time from the states' declared
+// transitions and maps (event, state index) to the next state index.
+enum class Event : std::uint8_t
+{
+    REQUEST_1 = 0,
+    REQUEST_2 = 1
+};
+constexpr std::size_t EVENT_COUNT = 2;
+
+template <typename VariantT>
+class TransitionTable;
+
+template <typename... States>
+class TransitionTable<std::variant<States...>>
+{
+public:
+    static_assert(sizeof...(States) <= 256, "State indices must fit in one byte");
+    using Row = std::array<std::uint8_t, sizeof...(States)>;
+
+    template <typename StateT>
+    static constexpr std::uint8_t indexOf() { return static_cast<std::uint8_t>(std::variant<States...>(std::in_place_type<StateT>).index()); }
+
+    static constexpr std::array<Row, EVENT_COUNT> rows = {
+        Row{ indexOf<typename States::OnRequest1>()... },
+        Row{ indexOf<typename States::OnRequest2>()... }
+    };
+    static constexpr std::array<const char*, sizeof...(States)> names = { States::name... };
+};
+
+using VariantTransitionTable = TransitionTable<VariantState>;
+static_assert(VariantTransitionTable::rows[0][0] == VariantTransitionTable::indexOf<VariantStateB>());
+
+// The ContextBatch stores the current state of every context as one byte in a dense array. An event stream is
+// applied block by block: each block of states stays in the cache while all the events run over it, and every
+// event is a tight branch-free loop of table lookups that the compiler is free to vectorize.
+class ContextBatch
+{
+private:
+    static constexpr std::size_t BLOCK_SIZE = 16 * 1024;
+    std::vector<std::uint8_t> m_states;
+
+public:
+    explicit ContextBatch(const std::size_t size)
+        : m_states(size, VariantTransitionTable::indexOf<VariantStateA>())
+    { }
+
+    void apply(const std::span<const Event> events)
+    {
+        for (std::size_t begin = 0; begin < m_states.size(); begin += BLOCK_SIZE)
+        {
+            std::uint8_t* const block = m_states.data() + begin;
+            const std::size_t blockSize = std::min(BLOCK_SIZE, m_states.size() - begin);
+            for (const Event event : events)
+            {
+                const VariantTransitionTable::Row& row = VariantTransitionTable::rows[static_cast<std::size_t>(event)];
+                for (std::size_t i = 0; i < blockSize; ++i)
+                {
+                    block[i] = row[block[i]];
+                }
+            }
+        }
+    }
+    std::size_t countIn(const std::uint8_t stateIndex) const { return std::count(m_states.begin(), m_states.end(), stateIndex); }
+    const char* stateName(const std::size_t context) const { return VariantTransitionTable::names[m_states[context]]; }
+};
+
 int main()
 {
     Context* const context = new Context(new ConcreteStateA);
@@ -81,4 +219,18 @@ int main()
     std::cout << '\n';
     context->request2();
     delete context;
+
+    std::cout << "\nThe same machine without allocations on transitions:\n";
+    VariantContext variantContext;
+    std::cout << '\n';
+    variantContext.request1();
+    std::cout << '\n';
+    variantContext.request2();
+
+    std::cout << "\nA batch of contexts stepped by an event stream through the transition table:\n";
+    ContextBatch batch(1'000'000);
+    const std::array<Event, 3> events = { Event::REQUEST_1, Event::REQUEST_2, Event::REQUEST_1 };
+    batch.apply(events);
+    std::cout << "Contexts in VariantStateB: " << batch.countIn(VariantTransitionTable::indexOf<VariantStateB>())
+              << ", the first one is in " << batch.stateName(0) << ".\n";
 }
@@ -0,0 +1,98 @@
+// A size sweep of the sorting strategies of Strategy_Conceptual_Example.cpp, from 16 bytes up to 1 GiB by default.
+// Every cell is the time per byte of a sort, without the copy that restores the unsorted input before each run.
+// The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 -pthread Strategy_Benchmark.cpp -o Strategy_Benchmark
+//     ./Strategy_Benchmark [largest size in bytes]
+// The sweep needs twice the largest size in memory. The cutoffs of AdaptiveSortStrategy::select() come from it.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main strategyExampleMain
+#include "Strategy_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// Repeats copying size bytes of the input into the work buffer, with or without sorting them, until about 16 MiB
+// and at least one run have been processed, and returns the nanoseconds per byte of one run. Short runs take
+// their bytes from different places of the input, so that the branch predictor can't learn a single input.
+double nanosecondsPerByte(const Strategy* const strategy, const std::span<const char> input, const std::span<char> work,
+                          const std::size_t size)
+{
+    constexpr std::size_t BYTES_PER_CELL = 16 * 1024 * 1024;
+    const std::size_t runs = std::max<std::size_t>(BYTES_PER_CELL / size, 1);
+    const std::size_t offsetCount = input.size() / size;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t run = 0; run < runs; ++run)
+    {
+        std::memcpy(work.data(), input.data() + run % offsetCount * size, size);
+        if (strategy != nullptr)
+        {
+            strategy->doAlgorithmInPlace(work.first(size));
+        }
+        // Keeps the compiler from dropping the copies that aren't sorted.
+        asm volatile("" : : "r"(work.data()) : "memory");
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(runs * size);
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t largestSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t(1) << 30;
+
+    // Small sweeps still get a few MiB of input to vary their runs.
+    std::vector<char> input(std::max<std::size_t>(largestSize, 4 * 1024 * 1024));
+    std::mt19937_64 random(42);
+    for (char& value : input)
+    {
+        value = static_cast<char>(random());
+    }
+    std::vector<char> work(largestSize);
+
+    const ConcreteStrategyA standardSort;
+    const SmallSortStrategy smallSort;
+    const CountingSortStrategy countingSort;
+    const ParallelSortStrategy parallelSort;
+    const AdaptiveSortStrategy adaptiveSort;
+    const std::array<std::pair<const char*, const Strategy*>, 5> strategies = { {
+        { "std::sort", &standardSort },
+        { "small", &smallSort },
+        { "counting", &countingSort },
+        { "parallel", &parallelSort },
+        { "adaptive", &adaptiveSort },
+    } };
+
+    std::printf("%d hardware threads, ns/byte\n%12s", static_cast<int>(std::thread::hardware_concurrency()), "bytes");
+    for (const auto& [name, strategy] : strategies)
+    {
+        std::printf("%12s", name);
+    }
+    std::printf("\n");
+    for (std::size_t size = 16; size <= largestSize; size *= 2)
+    {
+        const std::span<char> buffer(work.data(), size);
+        const double copy = nanosecondsPerByte(nullptr, input, work, size);
+        std::printf("%12zu", size);
+        for (const auto& [name, strategy] : strategies)
+        {
+            // Above its limit the small sort only forwards to the counting sort.
+            if (strategy == &smallSort && size > SmallSortStrategy::MAX_SIZE)
+            {
+                std::printf("%12s", "-");
+                continue;
+            }
+            std::printf("%12.3f", std::max(nanosecondsPerByte(strategy, input, work, size) - copy, 0.0));
+            if (!std::is_sorted(buffer.begin(), buffer.end()))
+            {
+                std::printf("\nFAILED: %s didn't sort %zu bytes.\n", name, size);
+                return 1;
+            }
+        }
+        std::printf("\n");
+    }
+}
@@ -1,38 +1,273 @@
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
 // The Strategy interface declares operations common to all supported versions of some algorithm.
-// The Context uses this interface to call the algorithm defined by Concrete Strategies.
+// The Context uses this interface to call the algorithm defined by Concrete Strategies. The algorithm
+// works in place on a span, so processing a large buffer needs no extra allocation or copy.
 class Strategy
 {
 public:
+    // The input sizes a strategy is meant for. Selectors such as the AdaptiveContext don't try it on other sizes.
+    struct SizeRange
+    {
+        std::size_t min = 0;
+        std::size_t max = std::numeric_limits<std::size_t>::max();
+
+        bool contains(const std::size_t size) const { return min <= size && size <= max; }
+    };
+
     virtual ~Strategy() = default;
-    virtual std::string doAlgorithm(std::string data) const = 0;
+    virtual void doAlgorithmInPlace(std::span<char> data) const = 0;
+    virtual SizeRange sizeRange() const { return {}; }
+
+    // Any contiguous range of chars (std::vector<char>, std::array<char, N>, ...) can be processed in place.
+    template <std::ranges::contiguous_range Range>
+        requires std::same_as<std::ranges::range_value_t<Range>, char>
+    void doAlgorithmInPlace(Range& data) const
+    {
+        doAlgorithmInPlace(std::span<char>(std::ranges::data(data), std::ranges::size(data)));
+    }
+    // The by-value interface is kept as a wrapper for callers that want a sorted copy.
+    std::string doAlgorithm(std::string data) const
+    {
+        doAlgorithmInPlace(std::span<char>(data));
+        return data;
+    }
 };
 
 // Concrete Strategies implement the algorithm while following the base Strategy
 // interface. The interface makes them interchangeable in the Context.
 class ConcreteStrategyA : public Strategy
 {
-private:
-    std::string doAlgorithm(std::string data) const override
+public:
+    void doAlgorithmInPlace(const std::span<char> data) const override
     {
         std::sort(std::begin(data), std::end(data));
-        return data;
     }
 };
 
 class ConcreteStrategyB : public Strategy
 {
+public:
+    void doAlgorithmInPlace(const std::span<char> data) const override
+    {
+        std::sort(std::begin(data), std::end(data), std::greater<char>());
+    }
+};
+
+// Specialized strategies can beat the generic comparison sort when the data is known to be bytes. They all sort in
+// the same (ascending) order as ConcreteStrategyA, so they can replace it where it is used.
+
+// For short inputs a branch-free compare-exchange network avoids the mispredicted branches of the generic sort.
+// The input is copied into a fixed buffer of unsigned keys padded to a power of two, which a bitonic network
+// sorts in O(n log^2 n) compare-exchanges. The network runs the same steps whatever the data, and the steps work
+// on contiguous blocks, which the compiler can vectorize. Longer inputs go to the counting sort.
+class SmallSortStrategy : public Strategy
+{
+public:
+    static constexpr std::size_t MAX_SIZE = 64;
+
+    void doAlgorithmInPlace(std::span<char> data) const override;
+    SizeRange sizeRange() const override { return { 0, MAX_SIZE }; }
+
 private:
-    std::string doAlgorithm(std::string data) const override
+    using Keys = std::array<unsigned char, MAX_SIZE>;
+
+    // Flipping the sign bit maps the char order onto the unsigned order when char is signed. The padding is
+    // the largest key, so it sorts after the data.
+    static constexpr unsigned char KEY_BIAS = std::is_signed_v<char> ? 0x80 : 0x00;
+    static constexpr unsigned char PADDING = 0xFF;
+
+    static void compareExchange(unsigned char& low, unsigned char& high)
     {
-        std::sort(std::begin(data), std::end(data), std::greater<std::string::value_type>());
-        return data;
+        // The swap is computed with a mask instead of a branch, which would be mispredicted on random data.
+        const unsigned int first = low;
+        const unsigned int second = high;
+        const unsigned int swap = (first ^ second) & -static_cast<unsigned int>(second < first);
+        low = static_cast<unsigned char>(first ^ swap);
+        high = static_cast<unsigned char>(second ^ swap);
+    }
+    static void sortNetwork(Keys& keys, const std::size_t size)
+    {
+        for (std::size_t block = 2; block <= size; block *= 2)
+        {
+            // Merging two sorted halves: the first step compares the halves back to front, which makes every
+            // half bitonic, and the following steps clean them up in place.
+            for (std::size_t begin = 0; begin < size; begin += block)
+            {
+                for (std::size_t i = 0; i < block / 2; ++i)
+                {
+                    compareExchange(keys[begin + i], keys[begin + block - 1 - i]);
+                }
+            }
+            for (std::size_t distance = block / 4; distance > 0; distance /= 2)
+            {
+                for (std::size_t begin = 0; begin < size; begin += 2 * distance)
+                {
+                    for (std::size_t i = begin; i < begin + distance; ++i)
+                    {
+                        compareExchange(keys[i], keys[i + distance]);
+                    }
+                }
+            }
+        }
     }
 };
 
+// A byte has only 256 values, so counting them and writing them back out sorts in linear time.
+class CountingSortStrategy : public Strategy
+{
+public:
+    using Histogram = std::array<std::size_t, 1 << CHAR_BIT>;
+
+    static void count(const char* const begin, const char* const end, Histogram& histogram)
+    {
+        for (const char* it = begin; it != end; ++it)
+        {
+            ++histogram[static_cast<unsigned char>(*it)];
+        }
+    }
+    // Writes the sorted output positions [from, to) for the given histogram. The buckets are walked in char
+    // order (char may be signed), so the result is the same as the one of std::sort.
+    static void fill(char* const output, const std::size_t from, const std::size_t to, const Histogram& histogram)
+    {
+        std::size_t position = 0;
+        for (int value = CHAR_MIN; value <= CHAR_MAX && position < to; ++value)
+        {
+            const std::size_t next = position + histogram[static_cast<unsigned char>(value)];
+            const std::size_t first = std::max(position, from);
+            const std::size_t last = std::min(next, to);
+            if (first < last)
+            {
+                std::fill(output + first, output + last, static_cast<char>(value));
+            }
+            position = next;
+        }
+    }
+
+    void doAlgorithmInPlace(const std::span<char> data) const override
+    {
+        Histogram histogram{};
+        count(data.data(), data.data() + data.size(), histogram);
+        fill(data.data(), 0, data.size(), histogram);
+    }
+};
+
+void SmallSortStrategy::doAlgorithmInPlace(const std::span<char> data) const
+{
+    if (data.size() > MAX_SIZE)
+    {
+        CountingSortStrategy().doAlgorithmInPlace(data);
+        return;
+    }
+    Keys keys;
+    const std::size_t size = std::bit_ceil(std::max<std::size_t>(data.size(), 1));
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        keys[i] = static_cast<unsigned char>(data[i]) ^ KEY_BIAS;
+    }
+    std::fill(keys.begin() + data.size(), keys.begin() + size, PADDING);
+    sortNetwork(keys, size);
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<char>(keys[i] ^ KEY_BIAS);
+    }
+}
+
+// For huge buffers the counting sort is split across threads: every thread counts its own chunk, then
+// the histograms are merged and every thread writes its own slice of the sorted output.
+class ParallelSortStrategy : public Strategy
+{
+public:
+    void doAlgorithmInPlace(const std::span<char> data) const override
+    {
+        const std::size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+        const std::size_t chunkSize = (data.size() + threadCount - 1) / threadCount;
+        std::vector<CountingSortStrategy::Histogram> histograms(threadCount, CountingSortStrategy::Histogram{});
+        runInParallel(threadCount, [&](const std::size_t index)
+        {
+            const std::size_t from = std::min(index * chunkSize, data.size());
+            const std::size_t to = std::min(from + chunkSize, data.size());
+            CountingSortStrategy::count(data.data() + from, data.data() + to, histograms[index]);
+        });
+
+        CountingSortStrategy::Histogram total{};
+        for (const CountingSortStrategy::Histogram& histogram : histograms)
+        {
+            std::transform(total.begin(), total.end(), histogram.begin(), total.begin(), std::plus<std::size_t>());
+        }
+        runInParallel(threadCount, [&](const std::size_t index)
+        {
+            const std::size_t from = std::min(index * chunkSize, data.size());
+            const std::size_t to = std::min(from + chunkSize, data.size());
+            CountingSortStrategy::fill(data.data(), from, to, total);
+        });
+    }
+
+private:
+    template <typename Func>
+    static void runInParallel(const std::size_t threadCount, const Func& func)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (std::size_t index = 1; index < threadCount; ++index)
+        {
+            threads.emplace_back(func, index);
+        }
+        func(0);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+};
+
+// The AdaptiveSortStrategy is a strategy selector: it forwards every input to the specialized
+// strategy that is expected to be the fastest for its size. The cutoffs come from Strategy_Benchmark.cpp: the
+// network is ahead of the counting sort up to 32 bytes and even with it at 64, and the threads of the parallel
+// sort only pay off on buffers of many megabytes.
+class AdaptiveSortStrategy : public Strategy
+{
+public:
+    static constexpr std::size_t SMALL_SORT_MAX_SIZE = 32;
+    static constexpr std::size_t PARALLEL_MIN_SIZE = 16 * 1024 * 1024;
+
+    const Strategy& select(const std::size_t size) const
+    {
+        if (size <= SMALL_SORT_MAX_SIZE)
+        {
+            return m_smallSort;
+        }
+        if (size < PARALLEL_MIN_SIZE)
+        {
+            return m_countingSort;
+        }
+        return m_parallelSort;
+    }
+    void doAlgorithmInPlace(const std::span<char> data) const override { select(data.size()).doAlgorithmInPlace(data); }
+
+private:
+    SmallSortStrategy m_smallSort;
+    CountingSortStrategy m_countingSort;
+    ParallelSortStrategy m_parallelSort;
+};
+
 // The Context defines the interface of interest to clients.
 class Context
 {
@@ -51,11 +286,18 @@ public:
     // The Context delegates some work to the Strategy object instead of
     // implementing multiple versions of the algorithm on its own.
     void doSomeBusinessLogic() const
+    {
+        std::string data = "aecbd";
+        doSomeBusinessLogic(data);
+    }
+    // The same business logic on a caller-owned buffer, which is sorted in place.
+    void doSomeBusinessLogic(const std::span<char> data) const
     {
         if (m_strategy)
         {
+            m_strategy->doAlgorithmInPlace(data);
             std::cout << "Context: Sorting data using the strategy (not sure how it'll do it)\n"
-                      << m_strategy->doAlgorithm("aecbd") << '\n';
+                      << std::string_view(data.data(), data.size()) << '\n';
         }
         else
         {
@@ -64,6 +306,207 @@ public:
     }
 };
 
+// When the strategy is known at compile time, the Context can take it as a policy instead. The strategy is stored by
+// value and called non-virtually, so there is neither a heap object nor a virtual call and the algorithm can be
+// inlined into the business logic.
+template <typename StrategyT>
+void runStrategy(const StrategyT& strategy, const std::span<char> data)
+{
+    // The qualified call bypasses the virtual dispatch.
+    strategy.StrategyT::doAlgorithmInPlace(data);
+}
+
+template <typename StrategyT>
+class StaticContext
+{
+private:
+    StrategyT m_strategy;
+
+public:
+    void doSomeBusinessLogic(const std::span<char> data) const
+    {
+        runStrategy(m_strategy, data);
+        std::cout << "StaticContext: Sorting data using the strategy (known at compile time)\n"
+                  << std::string_view(data.data(), data.size()) << '\n';
+    }
+};
+
+// For a closed set of strategies chosen at runtime, the VariantContext stores the current one by value in a
+// std::variant. setStrategy still works at runtime, and a call is a single jump-table dispatch without a heap object.
+template <typename... Strategies>
+class VariantContext
+{
+private:
+    std::variant<Strategies...> m_strategy;
+
+public:
+    template <typename StrategyT>
+    void setStrategy() { m_strategy.template emplace<StrategyT>(); }
+    void doSomeBusinessLogic(const std::span<char> data) const
+    {
+        std::visit([data](const auto& strategy) { runStrategy(strategy, data); }, m_strategy);
+        std::cout << "VariantContext: Sorting data using the strategy (one of a closed set)\n"
+                  << std::string_view(data.data(), data.size()) << '\n';
+    }
+};
+
+// The AdaptiveContext picks the strategy by itself instead of relying on the client's choice. The inputs are grouped
+// in buckets by their size (a power of two each) and every bucket is routed to the strategy that is currently the
+// fastest for it. Every run is timed, and every SAMPLE_PERIOD-th input of a bucket is given to the next strategy in
+// turn, so the statistics keep following the workload. Only the strategies whose size range contains the size of
+// an input are tried on it, so a strategy meant for small inputs is never sampled on a huge one. All the registered
+// strategies must compute the same result.
+class AdaptiveContext
+{
+public:
+    struct Timing
+    {
+        std::uint64_t samples = 0;
+        // Exponentially smoothed, so that older samples fade out as the workload shifts.
+        double nanosecondsPerByte = 0.0;
+    };
+
+    static constexpr std::uint64_t SAMPLE_PERIOD = 32;
+    static constexpr double SMOOTHING = 0.25;
+
+private:
+    struct Bucket
+    {
+        std::vector<Timing> timings;
+        std::size_t fastest = 0;
+        std::uint64_t calls = 0;
+        std::size_t nextSample = 0;
+    };
+
+    std::vector<std::string> m_names;
+    std::vector<std::unique_ptr<Strategy>> m_strategies;
+    std::array<Bucket, std::numeric_limits<std::size_t>::digits + 1> m_buckets;
+
+    static std::size_t bucketIndex(const std::size_t size) { return std::bit_width(size); }
+
+    bool applies(const std::size_t strategy, const std::size_t size) const { return m_strategies[strategy]->sizeRange().contains(size); }
+
+    // Returns the number of strategies if none applies to the size.
+    std::size_t pick(Bucket& bucket, const std::size_t size) const
+    {
+        const std::size_t count = m_strategies.size();
+        for (std::size_t strategy = 0; strategy < count; ++strategy)
+        {
+            if (bucket.timings[strategy].samples == 0 && applies(strategy, size))
+            {
+                return strategy;
+            }
+        }
+        if (++bucket.calls % SAMPLE_PERIOD == 0)
+        {
+            for (std::size_t step = 0; step < count; ++step)
+            {
+                bucket.nextSample = (bucket.nextSample + 1) % count;
+                if (applies(bucket.nextSample, size))
+                {
+                    return bucket.nextSample;
+                }
+            }
+            return count;
+        }
+        if (applies(bucket.fastest, size))
+        {
+            return bucket.fastest;
+        }
+        // The bucket's fastest strategy may cover only a part of the bucket's sizes.
+        std::size_t fastest = count;
+        for (std::size_t strategy = 0; strategy < count; ++strategy)
+        {
+            if (applies(strategy, size) && (fastest == count || bucket.timings[strategy].nanosecondsPerByte < bucket.timings[fastest].nanosecondsPerByte))
+            {
+                fastest = strategy;
+            }
+        }
+        return fastest;
+    }
+    static void record(Bucket& bucket, const std::size_t strategy, const double nanosecondsPerByte)
+    {
+        Timing& timing = bucket.timings[strategy];
+        timing.nanosecondsPerByte = timing.samples == 0 ? nanosecondsPerByte : timing.nanosecondsPerByte + SMOOTHING * (nanosecondsPerByte - timing.nanosecondsPerByte);
+        ++timing.samples;
+        for (std::size_t index = 0; index < bucket.timings.size(); ++index)
+        {
+            const Timing& candidate = bucket.timings[index];
+            if (candidate.samples != 0 && candidate.nanosecondsPerByte < bucket.timings[bucket.fastest].nanosecondsPerByte)
+            {
+                bucket.fastest = index;
+            }
+        }
+    }
+
+public:
+    void addStrategy(std::string name, std::unique_ptr<Strategy> strategy)
+    {
+        m_names.push_back(std::move(name));
+        m_strategies.push_back(std::move(strategy));
+        for (Bucket& bucket : m_buckets)
+        {
+            bucket.timings.emplace_back();
+        }
+    }
+    void doSomeBusinessLogic(const std::span<char> data)
+    {
+        if (m_strategies.empty())
+        {
+            std::cout << "AdaptiveContext: No strategy is registered\n";
+            return;
+        }
+        Bucket& bucket = m_buckets[bucketIndex(data.size())];
+        const std::size_t strategy = pick(bucket, data.size());
+        if (strategy == m_strategies.size())
+        {
+            std::cout << "AdaptiveContext: No strategy is registered for " << data.size() << " bytes\n";
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        m_strategies[strategy]->doAlgorithmInPlace(data);
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        record(bucket, strategy, elapsed.count() / static_cast<double>(std::max<std::size_t>(data.size(), 1)));
+    }
+
+    // The decision table and the statistics behind it can be inspected at runtime. Until a strategy is registered,
+    // the chosen strategy has an empty name and there are no timings.
+    std::string_view chosenStrategy(const std::size_t size) const
+    {
+        if (m_strategies.empty())
+        {
+            return {};
+        }
+        return m_names[m_buckets[bucketIndex(size)].fastest];
+    }
+    std::span<const Timing> timings(const std::size_t size) const { return m_buckets[bucketIndex(size)].timings; }
+    void printDecisionTable() const
+    {
+        for (std::size_t index = 0; index < m_buckets.size(); ++index)
+        {
+            const Bucket& bucket = m_buckets[index];
+            if (bucket.timings.empty() || bucket.timings[bucket.fastest].samples == 0)
+            {
+                continue;
+            }
+            std::cout << "AdaptiveContext: " << index << "-bit sizes use " << m_names[bucket.fastest] << " (";
+            for (std::size_t strategy = 0; strategy < m_names.size(); ++strategy)
+            {
+                std::cout << (strategy == 0 ? "" : ", ") << m_names[strategy] << ": ";
+                if (bucket.timings[strategy].samples == 0)
+                {
+                    std::cout << "not tried";
+                }
+                else
+                {
+                    std::cout << bucket.timings[strategy].nanosecondsPerByte << " ns/byte";
+                }
+            }
+            std::cout << ")\n";
+        }
+    }
+};
+
 // The client code picks a concrete strategy and passes it to the context. The client
 // should be aware of the differences between strategies in order to make the right choice.
 int main()
@@ -75,4 +518,41 @@ int main()
     std::cout << "\nClient: Strategy is set to reverse sorting.\n";
     context.setStrategy(std::make_unique<ConcreteStrategyB>());
     context.doSomeBusinessLogic();
+
+    std::cout << "\nClient: Strategy is set to size-adaptive sorting.\n";
+    context.setStrategy(std::make_unique<AdaptiveSortStrategy>());
+    context.doSomeBusinessLogic();
+
+    std::cout << "\nClient: The caller-owned buffer is sorted in place.\n";
+    std::vector<char> buffer = { 'd', 'a', 'e', 'b', 'c' };
+    context.doSomeBusinessLogic(buffer);
+
+    std::cout << "\nClient: The adaptive context picks the fastest strategy for every input size by itself.\n";
+    AdaptiveContext adaptiveContext;
+    adaptiveContext.addStrategy("ConcreteStrategyA", std::make_unique<ConcreteStrategyA>());
+    adaptiveContext.addStrategy("SmallSortStrategy", std::make_unique<SmallSortStrategy>());
+    adaptiveContext.addStrategy("CountingSortStrategy", std::make_unique<CountingSortStrategy>());
+    for (const std::size_t size : { 16, 4096 })
+    {
+        std::string data(size, ' ');
+        for (int run = 0; run < 100; ++run)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                data[i] = static_cast<char>('a' + (i * 7 + run) % 26);
+            }
+            adaptiveContext.doSomeBusinessLogic(data);
+        }
+    }
+    adaptiveContext.printDecisionTable();
+
+    std::cout << "\nClient: Strategy is fixed at compile time.\n";
+    std::string data = "aecbd";
+    const StaticContext<ConcreteStrategyA> staticContext;
+    staticContext.doSomeBusinessLogic(data);
+
+    std::cout << "\nClient: Strategy is picked at runtime from a closed set.\n";
+    VariantContext<ConcreteStrategyA, ConcreteStrategyB> variantContext;
+    variantContext.setStrategy<ConcreteStrategyB>();
+    variantContext.doSomeBusinessLogic(data);
 }
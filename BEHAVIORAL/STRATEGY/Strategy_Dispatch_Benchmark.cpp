@@ -0,0 +1,79 @@
+// A microbenchmark of the three ways Strategy_Conceptual_Example.cpp calls a strategy: through the virtual interface
+// held by the Context, inlined by the StaticContext, and through the std::variant of the VariantContext. The inputs
+// are a few bytes long, so that the dispatch is a large part of every call. The example is compiled in, with its
+// main() renamed.
+//     g++ -std=c++20 -O2 -pthread Strategy_Dispatch_Benchmark.cpp -o Strategy_Dispatch_Benchmark
+//     ./Strategy_Dispatch_Benchmark [calls per run]
+// The contexts print their results, so the calls are made the way each context makes them, without the printing.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main strategyExampleMain
+#include "Strategy_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// Sorts calls inputs of size bytes, taken in turn from the input, and returns the nanoseconds per call.
+template <typename Call>
+double nanosecondsPerCall(const std::size_t calls, const std::size_t size, const std::vector<char>& input, Call&& call)
+{
+    std::array<char, 64> work;
+    const std::size_t offsetCount = input.size() / size;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < calls; ++i)
+    {
+        std::memcpy(work.data(), input.data() + i % offsetCount * size, size);
+        call(std::span<char>(work.data(), size));
+        asm volatile("" : : "r"(work.data()) : "memory");
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(calls);
+}
+
+template <typename StrategyT>
+void compare(const char* const name, const std::size_t calls, const std::vector<char>& input)
+{
+    // The strategies are created at runtime, so that the compiler can't resolve the virtual call or the variant.
+    const std::unique_ptr<Strategy> virtualStrategy = std::make_unique<StrategyT>();
+    std::variant<ConcreteStrategyA, SmallSortStrategy, CountingSortStrategy> variantStrategy;
+    variantStrategy.template emplace<StrategyT>();
+    const StrategyT staticStrategy;
+
+    for (const std::size_t size : { 1, 2, 4, 8, 16 })
+    {
+        const double virtualCall = nanosecondsPerCall(calls, size, input, [&](const std::span<char> data)
+        {
+            virtualStrategy->doAlgorithmInPlace(data);
+        });
+        const double staticCall = nanosecondsPerCall(calls, size, input, [&](const std::span<char> data)
+        {
+            runStrategy(staticStrategy, data);
+        });
+        const double variantCall = nanosecondsPerCall(calls, size, input, [&](const std::span<char> data)
+        {
+            std::visit([data](const auto& strategy) { runStrategy(strategy, data); }, variantStrategy);
+        });
+        std::printf("%-20s %6zu %12.2f %12.2f %12.2f\n", name, size, virtualCall, staticCall, variantCall);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t calls = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    std::vector<char> input(1024 * 1024);
+    std::mt19937_64 random(42);
+    for (char& value : input)
+    {
+        value = static_cast<char>(random());
+    }
+
+    std::printf("%-20s %6s %12s %12s %12s\n", "strategy", "bytes", "virtual ns", "static ns", "variant ns");
+    compare<ConcreteStrategyA>("ConcreteStrategyA", calls, input);
+    compare<SmallSortStrategy>("SmallSortStrategy", calls, input);
+}
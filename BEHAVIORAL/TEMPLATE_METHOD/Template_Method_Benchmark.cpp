@@ -0,0 +1,89 @@
+// A benchmark of the template method of Template_Method_Conceptual_Example.cpp over a million objects: the per-object
+// loop of clientCode over the virtual AbstractClass and over the CRTP classes, against the step-major
+// TemplateMethodBatch on one thread and on every hardware thread. The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 -pthread Template_Method_Benchmark.cpp -o Template_Method_Benchmark
+//     ./Template_Method_Benchmark [object count]
+// The steps print their messages, so std::cout is silenced while they run; the calls that make them are still made.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main templateMethodExampleMain
+#include "Template_Method_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <cstdlib>
+#include <memory>
+
+template <typename Func>
+double nanosecondsPerObject(const std::size_t objectCount, Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(objectCount);
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t objectCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    // Both versions get the same mix of the two concrete classes, in the same order.
+    std::vector<std::unique_ptr<AbstractClass>> objects;
+    std::vector<ConcreteClassCRTP1> objectsCRTP1;
+    std::vector<ConcreteClassCRTP2> objectsCRTP2;
+    std::vector<bool> isFirstClass;
+    TemplateMethodBatch<ConcreteClassCRTP1, ConcreteClassCRTP2> batch;
+    for (std::size_t i = 0; i < objectCount; ++i)
+    {
+        const bool firstClass = (i * 2654435761u) % 3 != 0;
+        isFirstClass.push_back(firstClass);
+        if (firstClass)
+        {
+            objects.push_back(std::make_unique<ConcreteClass1>());
+            objectsCRTP1.emplace_back();
+            batch.emplace<ConcreteClassCRTP1>();
+        }
+        else
+        {
+            objects.push_back(std::make_unique<ConcreteClass2>());
+            objectsCRTP2.emplace_back();
+            batch.emplace<ConcreteClassCRTP2>();
+        }
+    }
+
+    std::cout.setstate(std::ios::badbit);
+    const double virtualLoop = nanosecondsPerObject(objectCount, [&objects]
+    {
+        for (const std::unique_ptr<AbstractClass>& object : objects)
+        {
+            clientCode(object.get());
+        }
+    });
+    const double crtpLoop = nanosecondsPerObject(objectCount, [&]
+    {
+        std::size_t first = 0;
+        std::size_t second = 0;
+        for (const bool firstClass : isFirstClass)
+        {
+            if (firstClass)
+            {
+                clientCode(objectsCRTP1[first++]);
+            }
+            else
+            {
+                clientCode(objectsCRTP2[second++]);
+            }
+        }
+    });
+    const double batchOneThread = nanosecondsPerObject(objectCount, [&batch] { batch.run(1); });
+    const double batchAllThreads = nanosecondsPerObject(objectCount, [&batch] { batch.run(); });
+    std::cout.clear();
+
+    std::cout << objectCount << " objects, ns/object\n"
+              << "clientCode, virtual              " << virtualLoop << '\n'
+              << "clientCode, CRTP                 " << crtpLoop << '\n'
+              << "TemplateMethodBatch, 1 thread    " << batchOneThread << '\n'
+              << "TemplateMethodBatch, all threads " << batchAllThreads << " (" << std::thread::hardware_concurrency()
+              << " hardware threads)\n";
+}
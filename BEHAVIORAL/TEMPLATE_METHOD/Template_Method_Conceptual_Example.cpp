@@ -1,4 +1,97 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The steps of the template method. They are used to attribute the measured latencies.
+enum class Step
+{
+    BASE_OPERATION_1,
+    REQUIRED_OPERATIONS_1,
+    BASE_OPERATION_2,
+    HOOK_1,
+    REQUIRED_OPERATION_2,
+    BASE_OPERATION_3,
+    HOOK_2,
+    COUNT
+};
+constexpr std::array<const char*, static_cast<std::size_t>(Step::COUNT)> STEP_NAMES = {
+    "baseOperation1", "requiredOperations1", "baseOperation2", "hook1", "requiredOperation2", "baseOperation3", "hook2"
+};
+
+// The LatencyHistogram counts the latencies in power-of-two nanosecond buckets. Recording is one relaxed atomic
+// increment, so the histogram can be read at runtime while other threads keep recording into it.
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t BUCKET_COUNT = 40;
+
+    void record(const std::chrono::nanoseconds latency)
+    {
+        const std::size_t bucket = std::bit_width(static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(latency.count(), 0)));
+        m_buckets[std::min(bucket, BUCKET_COUNT - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+    // Bucket i counts the latencies in [2^(i-1), 2^i) nanoseconds.
+    std::uint64_t bucket(const std::size_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    std::uint64_t count() const
+    {
+        std::uint64_t total = 0;
+        for (const std::atomic<std::uint64_t>& bucket : m_buckets)
+        {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> m_buckets{};
+};
+
+// The StepLatencies holds one histogram per step of the template method.
+class StepLatencies
+{
+public:
+    template <typename Func>
+    void time(const Step step, const Func& func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        m_histograms[static_cast<std::size_t>(step)].record(std::chrono::steady_clock::now() - start);
+    }
+    const LatencyHistogram& histogram(const Step step) const { return m_histograms[static_cast<std::size_t>(step)]; }
+    void print() const
+    {
+        for (std::size_t step = 0; step < m_histograms.size(); ++step)
+        {
+            const LatencyHistogram& histogram = m_histograms[step];
+            if (histogram.count() == 0)
+            {
+                continue;
+            }
+            std::cout << STEP_NAMES[step] << ":";
+            for (std::size_t index = 0; index < LatencyHistogram::BUCKET_COUNT; ++index)
+            {
+                if (histogram.bucket(index) != 0)
+                {
+                    std::cout << " <" << (std::uint64_t(1) << index) << "ns: " << histogram.bucket(index);
+                }
+            }
+            std::cout << '\n';
+        }
+    }
+
+private:
+    std::array<LatencyHistogram, static_cast<std::size_t>(Step::COUNT)> m_histograms;
+};
 
 // The Abstract Class defines a template method that contains a skeleton of some algorithm, composed of
 // calls to (usually) abstract primitive operations. Concrete subclasses should implement these operations,
@@ -10,14 +103,16 @@ public:
     // The template method defines the skeleton of an algorithm.
     void templateMethod() const
     {
-        baseOperation1();
-        requiredOperations1();
-        baseOperation2();
-        hook1();
-        requiredOperation2();
-        baseOperation3();
-        hook2();
+        runStep(Step::BASE_OPERATION_1, [this] { baseOperation1(); });
+        runStep(Step::REQUIRED_OPERATIONS_1, [this] { requiredOperations1(); });
+        runStep(Step::BASE_OPERATION_2, [this] { baseOperation2(); });
+        runStep(Step::HOOK_1, [this] { hook1(); });
+        runStep(Step::REQUIRED_OPERATION_2, [this] { requiredOperation2(); });
+        runStep(Step::BASE_OPERATION_3, [this] { baseOperation3(); });
+        runStep(Step::HOOK_2, [this] { hook2(); });
     }
+    // The per-step latency instrumentation is opt-in. Pass nullptr to turn it off again.
+    void setInstrumentation(StepLatencies* const latencies) { m_latencies = latencies; }
 
 protected:
     // These operations already have implementations.
@@ -33,6 +128,22 @@ protected:
     // (but empty) implementation. Hooks provide additional extension points in some crucial places of the algorithm.
     virtual void hook1() const {}
     virtual void hook2() const {}
+
+private:
+    StepLatencies* m_latencies = nullptr;
+
+    template <typename Func>
+    void runStep(const Step step, const Func& func) const
+    {
+        if (m_latencies)
+        {
+            m_latencies->time(step, func);
+        }
+        else
+        {
+            func();
+        }
+    }
 };
 
 // Concrete classes have to implement all abstract operations of the base class.
@@ -60,6 +171,173 @@ void clientCode(const AbstractClass* const c)
     c->templateMethod();
 }
 
+// The same skeleton can be bound at compile time with the Curiously Recurring Template Pattern. The steps are
+// called without virtual dispatch, and the hooks that a concrete class doesn't override compile away entirely,
+// even when the instrumentation is on, since the template method checks at compile time whether they are overridden.
+template <typename Derived>
+class AbstractClassCRTP
+{
+public:
+    void templateMethod() const
+    {
+        step<Step::BASE_OPERATION_1>();
+        step<Step::REQUIRED_OPERATIONS_1>();
+        step<Step::BASE_OPERATION_2>();
+        step<Step::HOOK_1>();
+        step<Step::REQUIRED_OPERATION_2>();
+        step<Step::BASE_OPERATION_3>();
+        step<Step::HOOK_2>();
+    }
+    // Runs a single step of the template method, so that the steps can also be driven from outside (see
+    // TemplateMethodBatch). A hook that Derived doesn't override is an empty function here.
+    template <Step S>
+    void step() const
+    {
+        if constexpr (S == Step::BASE_OPERATION_1)
+        {
+            runStep(S, [this] { baseOperation1(); });
+        }
+        else if constexpr (S == Step::REQUIRED_OPERATIONS_1)
+        {
+            runStep(S, [this] { derived().requiredOperations1(); });
+        }
+        else if constexpr (S == Step::BASE_OPERATION_2)
+        {
+            runStep(S, [this] { baseOperation2(); });
+        }
+        else if constexpr (S == Step::HOOK_1)
+        {
+            if constexpr (!std::is_same_v<decltype(&Derived::hook1), decltype(&AbstractClassCRTP::hook1)>)
+            {
+                runStep(S, [this] { derived().hook1(); });
+            }
+        }
+        else if constexpr (S == Step::REQUIRED_OPERATION_2)
+        {
+            runStep(S, [this] { derived().requiredOperation2(); });
+        }
+        else if constexpr (S == Step::BASE_OPERATION_3)
+        {
+            runStep(S, [this] { baseOperation3(); });
+        }
+        else if constexpr (S == Step::HOOK_2)
+        {
+            if constexpr (!std::is_same_v<decltype(&Derived::hook2), decltype(&AbstractClassCRTP::hook2)>)
+            {
+                runStep(S, [this] { derived().hook2(); });
+            }
+        }
+    }
+    void setInstrumentation(StepLatencies* const latencies) { m_latencies = latencies; }
+
+protected:
+    void baseOperation1() const { std::cout << "AbstractClassCRTP says: I am doing the bulk of the work\n"; }
+    void baseOperation2() const { std::cout << "AbstractClassCRTP says: But I let subclasses override some operations\n"; }
+    void baseOperation3() const { std::cout << "AbstractClassCRTP says: But I am doing the bulk of the work anyway\n"; }
+
+    // The default (empty) hooks. A concrete class hides them with its own version to override them.
+    void hook1() const {}
+    void hook2() const {}
+
+private:
+    StepLatencies* m_latencies = nullptr;
+
+    const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+    template <typename Func>
+    void runStep(const Step step, const Func& func) const
+    {
+        if (m_latencies)
+        {
+            m_latencies->time(step, func);
+        }
+        else
+        {
+            func();
+        }
+    }
+};
+
+class ConcreteClassCRTP1 : public AbstractClassCRTP<ConcreteClassCRTP1>
+{
+    friend class AbstractClassCRTP<ConcreteClassCRTP1>;
+
+protected:
+    void requiredOperations1() const { std::cout << "ConcreteClassCRTP1 says: Implemented Operation1\n"; }
+    void requiredOperation2() const { std::cout << "ConcreteClassCRTP1 says: Implemented Operation2\n"; }
+};
+
+class ConcreteClassCRTP2 : public AbstractClassCRTP<ConcreteClassCRTP2>
+{
+    friend class AbstractClassCRTP<ConcreteClassCRTP2>;
+
+protected:
+    void requiredOperations1() const { std::cout << "ConcreteClassCRTP2 says: Implemented Operation1\n"; }
+    void requiredOperation2() const { std::cout << "ConcreteClassCRTP2 says: Implemented Operation2\n"; }
+    void hook1() const { std::cout << "ConcreteClassCRTP2 says: Overridden Hook1\n"; }
+};
+
+template <typename Derived>
+void clientCode(const AbstractClassCRTP<Derived>& c)
+{
+    c.templateMethod();
+}
+
+// When the template method runs over millions of objects, the TemplateMethodBatch executes it step-major: step 1
+// for every object, then step 2 for every object, and so on, so that each step's code and data stay hot in the caches.
+// The objects are stored by value and grouped by their concrete class, so every step loop is monomorphic, and each
+// group is partitioned across threads.
+template <typename... Classes>
+class TemplateMethodBatch
+{
+private:
+    std::tuple<std::vector<Classes>...> m_groups;
+
+    template <typename Derived, std::size_t... Steps>
+    static void runStepMajor(const Derived* const begin, const Derived* const end, std::index_sequence<Steps...>)
+    {
+        const auto runAll = [begin, end]<Step S>()
+        {
+            for (const Derived* object = begin; object != end; ++object)
+            {
+                object->template step<S>();
+            }
+        };
+        (runAll.template operator()<static_cast<Step>(Steps)>(), ...);
+    }
+    // Runs the part of every group that belongs to the given thread.
+    void runSlice(const std::size_t thread, const std::size_t threadCount) const
+    {
+        std::apply([thread, threadCount](const auto&... groups)
+        {
+            (runStepMajor(groups.data() + groups.size() * thread / threadCount,
+                          groups.data() + groups.size() * (thread + 1) / threadCount,
+                          std::make_index_sequence<static_cast<std::size_t>(Step::COUNT)>{}), ...);
+        }, m_groups);
+    }
+
+public:
+    template <typename Derived, typename... Args>
+    Derived& emplace(Args&&... args) { return std::get<std::vector<Derived>>(m_groups).emplace_back(std::forward<Args>(args)...); }
+
+    // A thread count of 0 runs the batch on the calling thread, like a thread count of 1.
+    void run(const std::size_t requestedThreadCount = std::thread::hardware_concurrency()) const
+    {
+        const std::size_t threadCount = std::max<std::size_t>(requestedThreadCount, 1);
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (std::size_t thread = 1; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([this, thread, threadCount] { runSlice(thread, threadCount); });
+        }
+        runSlice(0, threadCount);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+};
+
 int main()
 {
     std::cout << "Same client code can work with different subclasses:\n";
@@ -70,4 +348,22 @@ int main()
     clientCode(concreteClass2);
     delete concreteClass1;
     delete concreteClass2;
+
+    std::cout << "\nThe same algorithm bound at compile time:\n";
+    const ConcreteClassCRTP1 concreteClassCRTP1;
+    clientCode(concreteClassCRTP1);
+    std::cout << "\nThe same algorithm bound at compile time, with the per-step latencies measured:\n";
+    StepLatencies latencies;
+    ConcreteClassCRTP2 concreteClassCRTP2;
+    concreteClassCRTP2.setInstrumentation(&latencies);
+    clientCode(concreteClassCRTP2);
+    std::cout << "\nPer-step latencies:\n";
+    latencies.print();
+
+    std::cout << "\nA batch runs every step for all its objects before the next step:\n";
+    TemplateMethodBatch<ConcreteClassCRTP1, ConcreteClassCRTP2> batch;
+    batch.emplace<ConcreteClassCRTP1>();
+    batch.emplace<ConcreteClassCRTP1>();
+    batch.emplace<ConcreteClassCRTP2>();
+    batch.run(1);
 }
@@ -0,0 +1,99 @@
+// A benchmark of the traversals of Visitor_Conceptual_Example.cpp over 10 million components: the double dispatch
+// over individually allocated components against the single dispatch over components stored by value in
+// std::variants, and the scaling of parallelClientCode over the thread count. All of them count the components
+// with the CountingVisitor. The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 -pthread Visitor_Benchmark.cpp -o Visitor_Benchmark
+//     ./Visitor_Benchmark [component count]
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main visitorExampleMain
+#include "Visitor_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+template <typename Func>
+double nanosecondsPerComponent(const std::size_t componentCount, Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(componentCount);
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t componentCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    // The classes are mixed at random, so that the dispatch can't be predicted from the position.
+    std::mt19937 random(42);
+    std::vector<std::unique_ptr<Component>> owners;
+    std::vector<const Component*> components;
+    std::vector<ComponentVariant> componentValues;
+    owners.reserve(componentCount);
+    components.reserve(componentCount);
+    componentValues.reserve(componentCount);
+    for (std::size_t i = 0; i < componentCount; ++i)
+    {
+        if (random() % 4 == 0)
+        {
+            owners.push_back(std::make_unique<ConcreteComponentB>());
+            componentValues.emplace_back(ConcreteComponentB());
+        }
+        else
+        {
+            owners.push_back(std::make_unique<ConcreteComponentA>());
+            componentValues.emplace_back(ConcreteComponentA());
+        }
+        components.push_back(owners.back().get());
+    }
+
+    CountingVisitor doubleDispatchCounts;
+    const double doubleDispatch = nanosecondsPerComponent(componentCount, [&components, &doubleDispatchCounts]
+    {
+        for (const Component* const component : components)
+        {
+            component->accept(&doubleDispatchCounts);
+        }
+    });
+    CountingVisitor variantCounts;
+    const double variant = nanosecondsPerComponent(componentCount, [&componentValues, &variantCounts]
+    {
+        clientCode(componentValues, variantCounts);
+    });
+
+    if (doubleDispatchCounts != variantCounts)
+    {
+        std::cout << "FAILED: the traversals counted different components.\n";
+        doubleDispatchCounts.printResult();
+        variantCounts.printResult();
+        return 1;
+    }
+    std::cout << componentCount << " components, ns/component\n"
+              << "double dispatch   " << doubleDispatch << '\n'
+              << "std::variant      " << variant << '\n';
+
+    std::cout << "\nparallelClientCode on " << std::thread::hardware_concurrency() << " hardware threads\n"
+              << "threads  ns/component  speedup\n";
+    const auto merge = [](CountingVisitor& result, const CountingVisitor& partial) { result.merge(partial); };
+    for (const std::size_t threadCount : { 1, 2, 4, 8, 16 })
+    {
+        CountingVisitor parallelCounts;
+        const double parallel = nanosecondsPerComponent(componentCount, [&]
+        {
+            parallelCounts = parallelClientCode(componentValues, CountingVisitor(), merge, threadCount);
+        });
+        if (parallelCounts != variantCounts)
+        {
+            std::cout << "FAILED: " << threadCount << " threads counted different components.\n";
+            return 1;
+        }
+        std::cout << threadCount << (threadCount < 10 ? "        " : "       ") << parallel << "       "
+                  << variant / parallel << '\n';
+    }
+}
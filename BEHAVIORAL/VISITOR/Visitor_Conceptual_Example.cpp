@@ -1,5 +1,12 @@
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <thread>
+#include <tuple>
+#include <variant>
+#include <vector>
 
 class ConcreteComponentA;
 class ConcreteComponentB;
@@ -73,6 +80,42 @@ public:
     }
 };
 
+// Visitors can also accumulate results. The visiting methods are const to fit the Visitor interface, so the
+// accumulated state is mutable; a visitor that is used from several threads must be copied for each of them.
+class CountingVisitor : public Visitor
+{
+public:
+    void visitConcreteComponentA(const ConcreteComponentA* const element) const override
+    {
+        ++m_countA;
+        m_totalLength += element->exclusiveMethodOfConcreteComponentA().size();
+    }
+    void visitConcreteComponentB(const ConcreteComponentB* const element) const override
+    {
+        ++m_countB;
+        m_totalLength += element->specialMethodOfConcreteComponentB().size();
+    }
+    void merge(const CountingVisitor& other)
+    {
+        m_countA += other.m_countA;
+        m_countB += other.m_countB;
+        m_totalLength += other.m_totalLength;
+    }
+    bool operator==(const CountingVisitor& other) const
+    {
+        return m_countA == other.m_countA && m_countB == other.m_countB && m_totalLength == other.m_totalLength;
+    }
+    void printResult() const
+    {
+        std::cout << "CountingVisitor: " << m_countA << " A, " << m_countB << " B, total length " << m_totalLength << '\n';
+    }
+
+private:
+    mutable std::size_t m_countA = 0;
+    mutable std::size_t m_countB = 0;
+    mutable std::size_t m_totalLength = 0;
+};
+
 // The client code can run visitor operations over any set of elements without figuring out their concrete
 // classes. The accept operation directs a call to the appropriate operation in the visitor object.
 void clientCode(const std::array<const Component*, 2>& components, const Visitor* const visitor)
@@ -83,6 +126,202 @@ void clientCode(const std::array<const Component*, 2>& components, const Visitor
     }
 }
 
+// When the set of component classes is closed, the components can be stored by value in a std::variant, in one
+// contiguous container instead of one heap allocation each. The variant's index selects the visiting method with a
+// single jump-table dispatch, and since the concrete visitor's type is known too, the visiting method itself is
+// called non-virtually: there is no accept call and no virtual call left.
+using ComponentVariant = std::variant<ConcreteComponentA, ConcreteComponentB>;
+
+template <typename VisitorT>
+void visitElement(const VisitorT& visitor, const ConcreteComponentA& element) { visitor.VisitorT::visitConcreteComponentA(&element); }
+template <typename VisitorT>
+void visitElement(const VisitorT& visitor, const ConcreteComponentB& element) { visitor.VisitorT::visitConcreteComponentB(&element); }
+
+template <typename VisitorT>
+void clientCode(const std::vector<ComponentVariant>& components, const VisitorT& visitor)
+{
+    for (const ComponentVariant& comp : components)
+    {
+        std::visit([&visitor](const auto& element) { visitElement(visitor, element); }, comp);
+    }
+}
+
+// The parallel visitation splits the components into one contiguous chunk per worker thread, and every worker
+// visits its chunk with its own copy of the identity visitor. The partial visitors are then merged by the
+// user-supplied reduction in chunk order, so for a given thread count the result doesn't depend on the thread
+// scheduling, even if the reduction isn't commutative. A thread count of 0 visits on the calling thread, like a
+// thread count of 1. The identity must be the neutral state of the reduction, such as an empty CountingVisitor,
+// since every worker starts from it: to continue from an existing state, reduce the result into that state.
+template <typename VisitorT, typename Reduce>
+VisitorT parallelClientCode(const std::vector<ComponentVariant>& components, const VisitorT& identity, const Reduce& reduce,
+                            const std::size_t requestedThreadCount = std::thread::hardware_concurrency())
+{
+    const std::size_t threadCount = std::max<std::size_t>(requestedThreadCount, 1);
+    // Every partial visitor gets its own cache line, so that the workers don't slow each other down by false sharing.
+    struct alignas(64) Partial
+    {
+        VisitorT visitor;
+    };
+    std::vector<Partial> partials(threadCount, Partial{ identity });
+    const auto visitChunk = [&components, &partials, threadCount](const std::size_t worker)
+    {
+        const std::size_t begin = components.size() * worker / threadCount;
+        const std::size_t end = components.size() * (worker + 1) / threadCount;
+        const VisitorT& partial = partials[worker].visitor;
+        for (std::size_t index = begin; index < end; ++index)
+        {
+            std::visit([&partial](const auto& element) { visitElement(partial, element); }, components[index]);
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount - 1);
+    for (std::size_t worker = 1; worker < threadCount; ++worker)
+    {
+        workers.emplace_back(visitChunk, worker);
+    }
+    visitChunk(0);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    VisitorT result = std::move(partials[0].visitor);
+    for (std::size_t worker = 1; worker < threadCount; ++worker)
+    {
+        reduce(result, partials[worker].visitor);
+    }
+    return result;
+}
+
+// The ComponentArray keeps the components of one concrete class contiguous and in insertion order. Insertion
+// appends, and removal only marks the slot as dead, so both are O(1). The dead slots are dropped in one pass once
+// they are the majority, which keeps the removal amortized O(1). The handles stay valid across that compaction.
+// The ids of removed components are reused, so every handle also carries the generation of its id, which is
+// bumped on removal: a handle whose component was removed is stale, even after its id is given out again.
+template <typename ComponentT>
+class ComponentArray
+{
+public:
+    struct Handle
+    {
+        std::size_t id;
+        std::uint32_t generation;
+    };
+
+    Handle insert(ComponentT component)
+    {
+        std::size_t id = m_handles.size();
+        if (m_freeHandles.empty())
+        {
+            m_handles.push_back({ m_slots.size(), 0 });
+        }
+        else
+        {
+            id = m_freeHandles.back();
+            m_freeHandles.pop_back();
+            m_handles[id].slot = m_slots.size();
+        }
+        m_slots.push_back({ std::move(component), id, true });
+        return { id, m_handles[id].generation };
+    }
+    bool contains(const Handle handle) const
+    {
+        return handle.id < m_handles.size() && m_handles[handle.id].generation == handle.generation;
+    }
+    // Returns false, and changes nothing, if the handle is stale: its component was already removed.
+    bool remove(const Handle handle)
+    {
+        if (!contains(handle))
+        {
+            return false;
+        }
+        HandleEntry& entry = m_handles[handle.id];
+        m_slots[entry.slot].alive = false;
+        ++entry.generation;
+        m_freeHandles.push_back(handle.id);
+        if (++m_deadCount * 2 > m_slots.size())
+        {
+            compact();
+        }
+        return true;
+    }
+    template <typename Func>
+    void forEach(const Func& func) const
+    {
+        for (const Slot& slot : m_slots)
+        {
+            if (slot.alive)
+            {
+                func(slot.component);
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        ComponentT component;
+        std::size_t handle;
+        bool alive;
+    };
+
+    struct HandleEntry
+    {
+        std::size_t slot;
+        std::uint32_t generation;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<HandleEntry> m_handles;
+    std::vector<std::size_t> m_freeHandles;
+    std::size_t m_deadCount = 0;
+
+    void compact()
+    {
+        std::erase_if(m_slots, [](const Slot& slot) { return !slot.alive; });
+        for (std::size_t index = 0; index < m_slots.size(); ++index)
+        {
+            m_handles[m_slots[index].handle].slot = index;
+        }
+        m_deadCount = 0;
+    }
+};
+
+// The ComponentStore partitions a heterogeneous scene by concrete class. A visitor runs one tight, devirtualized
+// loop per class over contiguous memory, instead of chasing pointers to the components in mixed order.
+template <typename... Components>
+class ComponentStore
+{
+private:
+    std::tuple<ComponentArray<Components>...> m_arrays;
+
+public:
+    template <typename ComponentT>
+    typename ComponentArray<ComponentT>::Handle insert(ComponentT component)
+    {
+        return std::get<ComponentArray<ComponentT>>(m_arrays).insert(std::move(component));
+    }
+    template <typename ComponentT>
+    bool remove(const typename ComponentArray<ComponentT>::Handle handle)
+    {
+        return std::get<ComponentArray<ComponentT>>(m_arrays).remove(handle);
+    }
+    template <typename VisitorT>
+    void accept(const VisitorT& visitor) const
+    {
+        std::apply([&visitor](const auto&... arrays)
+        {
+            (arrays.forEach([&visitor](const auto& element) { visitElement(visitor, element); }), ...);
+        }, m_arrays);
+    }
+};
+
+template <typename VisitorT, typename... Components>
+void clientCode(const ComponentStore<Components...>& store, const VisitorT& visitor)
+{
+    store.accept(visitor);
+}
+
 int main()
 {
     const std::array<const Component*, 2> components = { new ConcreteComponentA, new ConcreteComponentB };
@@ -100,4 +339,33 @@ int main()
     }
     delete visitor1;
     delete visitor2;
+
+    std::cout << "\nThe closed set of components can be stored by value and visited with a single dispatch:\n";
+    const std::vector<ComponentVariant> componentValues = { ConcreteComponentA(), ConcreteComponentB() };
+    clientCode(componentValues, ConcreteVisitor1());
+    clientCode(componentValues, ConcreteVisitor2());
+
+    std::cout << "\nA store keeps every component class in its own array and visits them class by class:\n";
+    ComponentStore<ConcreteComponentA, ConcreteComponentB> store;
+    store.insert(ConcreteComponentA());
+    const auto handleB = store.insert(ConcreteComponentB());
+    store.insert(ConcreteComponentA());
+    store.insert(ConcreteComponentB());
+    clientCode(store, ConcreteVisitor1());
+    std::cout << "After one ConcreteComponentB is removed:\n";
+    store.remove<ConcreteComponentB>(handleB);
+    clientCode(store, ConcreteVisitor2());
+    const auto handleReused = store.insert(ConcreteComponentB());
+    std::cout << "Its id is reused by the next component (" << (handleReused.id == handleB.id ? "yes" : "no")
+              << "), but removing it again through the stale handle is refused ("
+              << (store.remove<ConcreteComponentB>(handleB) ? "removed" : "refused") << ").\n";
+
+    std::cout << "\nAn accumulating visitor can run on several threads, each with its own state:\n";
+    std::vector<ComponentVariant> scene;
+    for (int index = 0; index < 1000; ++index)
+    {
+        scene.push_back(index % 4 == 0 ? ComponentVariant(ConcreteComponentB()) : ComponentVariant(ConcreteComponentA()));
+    }
+    const CountingVisitor counts = parallelClientCode(scene, CountingVisitor(), [](CountingVisitor& result, const CountingVisitor& partial) { result.merge(partial); }, 4);
+    counts.printResult();
 }
\ No newline at end of file
@@ -0,0 +1,253 @@
+// Benchmarks and a test of Abstract_Factory_Conceptual_Example.cpp. The example is compiled in, with its main() renamed.
+// - The FactoryRegistry with hundreds of product families, against a std::unordered_map of the same names. Three
+//   quarters of the lookups hit a family and the rest miss.
+// - Products made by producer threads and deleted by consumer threads, from the slab pools and from the heap.
+// - Products made and deleted by thread_local destructors after their thread gave up its slab cache, which must
+//   neither crash nor leave a new cache behind for every thread.
+//     g++ -std=c++20 -O2 -pthread Abstract_Factory_Benchmark.cpp -o Abstract_Factory_Benchmark
+//     ./Abstract_Factory_Benchmark [lookup count] [products per producer]
+// The program exits with a non-zero status if a check fails.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main abstractFactoryExampleMain
+#include "Abstract_Factory_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <unordered_map>
+
+// The family names "Family000", "Family001", ... are generated at compile time, so that the registry can refer
+// to them.
+constexpr std::size_t FAMILY_COUNT = 500;
+constexpr std::size_t NAME_LENGTH = 9;
+
+constexpr std::array<std::array<char, NAME_LENGTH>, FAMILY_COUNT> makeFamilyNames()
+{
+    std::array<std::array<char, NAME_LENGTH>, FAMILY_COUNT> names{};
+    for (std::size_t family = 0; family < FAMILY_COUNT; ++family)
+    {
+        constexpr std::string_view prefix = "Family";
+        std::copy(prefix.begin(), prefix.end(), names[family].begin());
+        names[family][6] = static_cast<char>('0' + family / 100);
+        names[family][7] = static_cast<char>('0' + family / 10 % 10);
+        names[family][8] = static_cast<char>('0' + family % 10);
+    }
+    return names;
+}
+constexpr std::array<std::array<char, NAME_LENGTH>, FAMILY_COUNT> FAMILY_NAMES = makeFamilyNames();
+
+constexpr std::string_view familyName(const std::size_t family) { return std::string_view(FAMILY_NAMES[family].data(), NAME_LENGTH); }
+
+constexpr std::array<FactoryEntry, FAMILY_COUNT> makeEntries()
+{
+    std::array<FactoryEntry, FAMILY_COUNT> entries{};
+    for (std::size_t family = 0; family < FAMILY_COUNT; ++family)
+    {
+        entries[family] = FactoryEntry{ familyName(family), family % 2 == 0 ? &lazyInstance<ConcreteFactory1> : &lazyInstance<ConcreteFactory2> };
+    }
+    return entries;
+}
+constexpr FactoryRegistry<FAMILY_COUNT> LARGE_REGISTRY(makeEntries());
+
+template <typename Find>
+double nanosecondsPerLookup(const std::vector<std::string>& names, const std::vector<std::uint16_t>& queries, std::size_t& found, Find&& find)
+{
+    found = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const std::uint16_t query : queries)
+    {
+        found += find(std::string_view(names[query])) != nullptr;
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(queries.size());
+}
+
+bool lookupBenchmark(const std::size_t lookupCount)
+{
+    std::unordered_map<std::string_view, const AbstractFactory*> map;
+    for (std::size_t family = 0; family < FAMILY_COUNT; ++family)
+    {
+        map.emplace(familyName(family), &(family % 2 == 0 ? lazyInstance<ConcreteFactory1>() : lazyInstance<ConcreteFactory2>()));
+    }
+
+    // The lookups pick from a few thousand names in random order, so that they don't follow a pattern.
+    std::mt19937 random(42);
+    std::vector<std::string> names;
+    for (std::size_t name = 0; name < 4096; ++name)
+    {
+        const std::string family(familyName(random() % FAMILY_COUNT));
+        names.push_back(name % 4 == 3 ? family + "x" : family);
+    }
+    std::vector<std::uint16_t> queries(lookupCount);
+    for (std::uint16_t& query : queries)
+    {
+        query = static_cast<std::uint16_t>(random() % names.size());
+    }
+
+    std::size_t registryFound = 0;
+    const double registry = nanosecondsPerLookup(names, queries, registryFound, [](const std::string_view name) { return LARGE_REGISTRY.find(name); });
+    std::size_t mapFound = 0;
+    const double unorderedMap = nanosecondsPerLookup(names, queries, mapFound, [&map](const std::string_view name) -> const AbstractFactory*
+    {
+        const auto it = map.find(name);
+        return it == map.end() ? nullptr : it->second;
+    });
+    if (registryFound != mapFound)
+    {
+        std::cout << "FAILED: the registry found " << registryFound << " families, the map " << mapFound << ".\n";
+        return false;
+    }
+    for (std::size_t family = 0; family < FAMILY_COUNT; ++family)
+    {
+        if (LARGE_REGISTRY.find(familyName(family)) != map.at(familyName(family)))
+        {
+            std::cout << "FAILED: the registry returns a wrong factory for " << familyName(family) << ".\n";
+            return false;
+        }
+    }
+
+    std::cout << FAMILY_COUNT << " families, " << lookupCount << " lookups, ns/lookup\n"
+              << "FactoryRegistry      " << registry << '\n'
+              << "std::unordered_map   " << unorderedMap << '\n';
+    return true;
+}
+
+// The same product as ConcreteProductA1, from the general purpose heap.
+class HeapProductA : public AbstractProductA
+{
+public:
+    std::string usefulFunctionA() const override { return "HeapProductA."; }
+};
+
+// Every producer hands its products over to its own consumer in chunks, through a queue under a mutex.
+template <typename ProductT>
+double productsPerSecond(const std::size_t pairCount, const std::size_t productCount)
+{
+    constexpr std::size_t CHUNK_SIZE = 256;
+    struct Channel
+    {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::vector<AbstractProductA*>> chunks;
+        bool done = false;
+    };
+    std::vector<Channel> channels(pairCount);
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (Channel& channel : channels)
+    {
+        threads.emplace_back([&channel, productCount]
+        {
+            std::vector<AbstractProductA*> chunk;
+            for (std::size_t index = 0; index < productCount; ++index)
+            {
+                chunk.push_back(new ProductT());
+                if (chunk.size() == CHUNK_SIZE || index + 1 == productCount)
+                {
+                    const std::lock_guard<std::mutex> lock(channel.mutex);
+                    channel.chunks.push_back(std::move(chunk));
+                    channel.done = index + 1 == productCount;
+                    channel.ready.notify_one();
+                    chunk.clear();
+                }
+            }
+        });
+        threads.emplace_back([&channel]
+        {
+            for (;;)
+            {
+                std::vector<AbstractProductA*> chunk;
+                {
+                    std::unique_lock<std::mutex> lock(channel.mutex);
+                    channel.ready.wait(lock, [&channel] { return channel.done || !channel.chunks.empty(); });
+                    if (channel.chunks.empty())
+                    {
+                        return;
+                    }
+                    chunk = std::move(channel.chunks.front());
+                    channel.chunks.pop_front();
+                }
+                for (AbstractProductA* const product : chunk)
+                {
+                    delete product;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(pairCount * productCount) / elapsed.count();
+}
+
+void slabBenchmark(const std::size_t productCount)
+{
+    std::cout << "\nProducers handing " << productCount << " products each over to consumers, products/s\n"
+              << "pairs  slab pool   heap\n";
+    for (const std::size_t pairCount : { 1, 2, 4 })
+    {
+        const double slab = productsPerSecond<ConcreteProductA1>(pairCount, productCount);
+        const double heap = productsPerSecond<HeapProductA>(pairCount, productCount);
+        std::cout << pairCount << "      " << static_cast<std::uint64_t>(slab) << "   " << static_cast<std::uint64_t>(heap) << '\n';
+    }
+}
+
+// The holder is constructed before the thread first allocates a product, so it is destroyed after the thread gave
+// up its slab cache. Its destructor deletes the products and makes and deletes one more.
+struct LateProductHolder
+{
+    std::vector<AbstractProductA*> products;
+
+    ~LateProductHolder()
+    {
+        for (AbstractProductA* const product : products)
+        {
+            delete product;
+        }
+        delete new ConcreteProductA2();
+    }
+};
+
+bool threadExitTest()
+{
+    constexpr std::size_t THREAD_COUNT = 64;
+    for (std::size_t thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+        std::thread([]
+        {
+            thread_local LateProductHolder holder;
+            for (int index = 0; index < 100; ++index)
+            {
+                holder.products.push_back(new ConcreteProductA2());
+            }
+        }).join();
+    }
+    // The threads run one after the other, so each of them should adopt the cache of the previous one.
+    const std::size_t cacheCount = SlabPool<ConcreteProductA2>::cacheCount();
+    std::cout << "\n" << THREAD_COUNT << " threads deleted products in thread_local destructors, using "
+              << cacheCount << " slab caches.\n";
+    if (cacheCount > 2)
+    {
+        std::cout << "FAILED: the threads left caches behind.\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t lookupCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    const std::size_t productCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+    if (!threadExitTest() || !lookupBenchmark(lookupCount))
+    {
+        return 1;
+    }
+    slabBenchmark(productCount);
+}
@@ -1,5 +1,504 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Products are created and destroyed at high rates from many threads, so they are not allocated one by one from the
+// general purpose heap. The SlabPool hands out fixed-size blocks carved from large slabs, and every thread has its
+// own cache of slabs and free blocks, so the common allocation and deallocation paths take no lock and touch no
+// shared memory. There is one pool per product type (see SlabAllocated below).
+//
+// A block freed by the thread that owns its slab goes back to that thread's free list. A block freed by another
+// thread is collected in a per-thread outgoing batch and returned to its home cache in one atomic push once the
+// batch is full, so a producer/consumer pair of threads doesn't contend on every product. A batch that stops
+// growing is sent home anyway after a while, and all the batches of a thread are sent home whenever it refills its
+// own free list. A thread that stops freeing and allocating keeps its last partial batches until it exits or calls
+// flushOutgoing(), so a consumer that goes idle should call it. The caches grow slab by slab with the load they see,
+// and when the load drops, they release the slabs whose blocks are all free again, except for a few kept for the
+// next burst. A cache outlives its thread, since other threads may still return blocks to it: when its thread exits,
+// it is handed over to the next thread that starts allocating. Products that are created or deleted by the
+// destructors of other thread_local objects, after the thread gave up its cache, take a slower locked path.
+template <typename T>
+class SlabPool
+{
+public:
+    static void* allocate()
+    {
+        if (Cache* const cache = localCache())
+        {
+            return cache->take();
+        }
+        // The thread has exited, so it borrows an unowned cache under the registry's lock.
+        Registry& caches = registry();
+        const std::lock_guard<std::mutex> lock(caches.mutex);
+        if (caches.orphans.empty())
+        {
+            caches.orphans.push_back(caches.caches.emplace_back(new Cache));
+        }
+        return caches.orphans.back()->take();
+    }
+    static void deallocate(void* const pointer)
+    {
+        Cache* const cache = localCache();
+        SlabHeader* const slab = slabOf(pointer);
+        Cache* const home = slab->home;
+        FreeBlock* const block = ::new (pointer) FreeBlock{ nullptr };
+        if (home == cache)
+        {
+            block->next = cache->m_freeList;
+            cache->m_freeList = block;
+            --slab->live;
+            if (++cache->m_freeCount > cache->m_trimThreshold)
+            {
+                cache->trim();
+            }
+        }
+        else if (cache != nullptr)
+        {
+            cache->sendHome(*home, block);
+        }
+        else
+        {
+            // The thread has exited, so the block goes home on its own.
+            OutgoingBatch batch{ home, block, block, 1, 0 };
+            Cache::flush(batch);
+        }
+    }
+    // Sends the blocks that the calling thread freed for other threads home now, instead of when their batches fill up.
+    static void flushOutgoing()
+    {
+        if (Cache* const cache = localCache())
+        {
+            cache->flushAll();
+        }
+    }
+    // The number of caches created so far, which is at most the number of threads that ever used the pool at once.
+    static std::size_t cacheCount()
+    {
+        const std::lock_guard<std::mutex> lock(registry().mutex);
+        return registry().caches.size();
+    }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+    struct Cache;
+    // Every slab is aligned to its size and starts with a header, so the home cache of a block is found by masking.
+    struct SlabHeader
+    {
+        Cache* home;
+        // The blocks of the slab that are not in its home cache's free list. Only the home cache's thread updates it.
+        std::size_t live;
+        bool released;
+    };
+    // Blocks freed by this thread that belong to another cache, to be sent home together.
+    struct OutgoingBatch
+    {
+        Cache* home = nullptr;
+        FreeBlock* head = nullptr;
+        FreeBlock* tail = nullptr;
+        std::size_t size = 0;
+        // The number of blocks that the thread had sent home when this batch got its first block.
+        std::uint64_t startedAt = 0;
+    };
+
+    static constexpr std::size_t ALIGNMENT = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    static constexpr std::size_t BLOCK_SIZE = (std::max(sizeof(T), sizeof(FreeBlock)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    static constexpr std::size_t FIRST_BLOCK = (sizeof(SlabHeader) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    static constexpr std::size_t SLAB_SIZE = std::bit_ceil(std::max<std::size_t>(64 * 1024, FIRST_BLOCK + BLOCK_SIZE));
+    static constexpr std::size_t BATCH_SIZE = 64;
+    static constexpr std::size_t OUTGOING_BATCH_COUNT = 4;
+    // A batch that got no block while the thread sent this many blocks home is sent home as it is.
+    static constexpr std::uint64_t STALE_BATCH_AGE = 2 * BATCH_SIZE;
+    // The free slabs that a cache keeps, and the number of free blocks at which it starts looking for free slabs.
+    static constexpr std::size_t KEPT_FREE_SLABS = 2;
+    static constexpr std::size_t TRIM_THRESHOLD = (KEPT_FREE_SLABS + 2) * ((SLAB_SIZE - FIRST_BLOCK) / BLOCK_SIZE);
+
+    static SlabHeader* slabOf(void* const pointer)
+    {
+        return reinterpret_cast<SlabHeader*>(reinterpret_cast<std::uintptr_t>(pointer) & ~(SLAB_SIZE - 1));
+    }
+
+    struct Cache
+    {
+        FreeBlock* m_freeList = nullptr;
+        std::size_t m_freeCount = 0;
+        std::size_t m_trimThreshold = TRIM_THRESHOLD;
+        // Blocks sent home by other threads, pushed as whole batches.
+        std::atomic<FreeBlock*> m_returned = nullptr;
+        char* m_carveCursor = nullptr;
+        char* m_carveEnd = nullptr;
+        std::array<OutgoingBatch, OUTGOING_BATCH_COUNT> m_outgoing;
+        std::size_t m_nextEviction = 0;
+        std::uint64_t m_sentHome = 0;
+        std::vector<void*> m_slabs;
+
+        void* take()
+        {
+            if (m_freeList == nullptr)
+            {
+                refill();
+            }
+            FreeBlock* const block = m_freeList;
+            m_freeList = block->next;
+            --m_freeCount;
+            ++slabOf(block)->live;
+            return block;
+        }
+        void refill()
+        {
+            // The thread is allocating again, so the blocks it holds for other caches shouldn't wait any longer.
+            flushAll();
+            m_freeList = m_returned.exchange(nullptr, std::memory_order_acquire);
+            if (m_freeList != nullptr)
+            {
+                for (FreeBlock* block = m_freeList; block != nullptr; block = block->next)
+                {
+                    --slabOf(block)->live;
+                    ++m_freeCount;
+                }
+                if (m_freeCount > m_trimThreshold)
+                {
+                    trim();
+                }
+                return;
+            }
+            if (m_carveCursor == m_carveEnd)
+            {
+                char* const slab = static_cast<char*>(::operator new(SLAB_SIZE, std::align_val_t(SLAB_SIZE)));
+                ::new (slab) SlabHeader{ this, 0, false };
+                m_slabs.push_back(slab);
+                m_carveCursor = slab + FIRST_BLOCK;
+                m_carveEnd = m_carveCursor + (SLAB_SIZE - FIRST_BLOCK) / BLOCK_SIZE * BLOCK_SIZE;
+            }
+            // Only a batch of blocks is carved at a time, so a slab's memory is touched when it's needed.
+            for (std::size_t count = 0; count < BATCH_SIZE && m_carveCursor != m_carveEnd; ++count)
+            {
+                m_freeList = ::new (m_carveCursor) FreeBlock{ m_freeList };
+                m_carveCursor += BLOCK_SIZE;
+                ++m_freeCount;
+            }
+        }
+        // Releases the slabs whose blocks are all in the free list, except for KEPT_FREE_SLABS of them. The slab that
+        // is still being carved is always kept. The threshold for the next trim grows with the free blocks that
+        // remain, so the free list is walked only after it has grown enough again.
+        void trim()
+        {
+            char* const carvedSlab = m_carveCursor == m_carveEnd ? nullptr : reinterpret_cast<char*>(slabOf(m_carveCursor));
+            std::size_t keptFreeSlabs = 0;
+            std::size_t releasedSlabs = 0;
+            for (void* const slab : m_slabs)
+            {
+                SlabHeader* const header = static_cast<SlabHeader*>(slab);
+                if (header->live == 0 && slab != carvedSlab && keptFreeSlabs++ >= KEPT_FREE_SLABS)
+                {
+                    header->released = true;
+                    ++releasedSlabs;
+                }
+            }
+            if (releasedSlabs != 0)
+            {
+                FreeBlock** link = &m_freeList;
+                m_freeCount = 0;
+                while (*link != nullptr)
+                {
+                    if (slabOf(*link)->released)
+                    {
+                        *link = (*link)->next;
+                    }
+                    else
+                    {
+                        link = &(*link)->next;
+                        ++m_freeCount;
+                    }
+                }
+                std::erase_if(m_slabs, [](void* const slab)
+                {
+                    if (!static_cast<SlabHeader*>(slab)->released)
+                    {
+                        return false;
+                    }
+                    ::operator delete(slab, std::align_val_t(SLAB_SIZE));
+                    return true;
+                });
+            }
+            m_trimThreshold = std::max(TRIM_THRESHOLD, 2 * m_freeCount);
+        }
+        void sendHome(Cache& home, FreeBlock* const block)
+        {
+            ++m_sentHome;
+            OutgoingBatch* batch = nullptr;
+            for (OutgoingBatch& candidate : m_outgoing)
+            {
+                if (candidate.home == &home)
+                {
+                    batch = &candidate;
+                }
+                else if (candidate.size != 0 && m_sentHome - candidate.startedAt > STALE_BATCH_AGE)
+                {
+                    flush(candidate);
+                }
+            }
+            if (batch == nullptr)
+            {
+                batch = &m_outgoing[m_nextEviction];
+                m_nextEviction = (m_nextEviction + 1) % m_outgoing.size();
+                flush(*batch);
+                batch->home = &home;
+                batch->tail = block;
+                batch->startedAt = m_sentHome;
+            }
+            block->next = batch->head;
+            batch->head = block;
+            if (++batch->size == BATCH_SIZE)
+            {
+                flush(*batch);
+            }
+        }
+        static void flush(OutgoingBatch& batch)
+        {
+            if (batch.size != 0)
+            {
+                FreeBlock* expected = batch.home->m_returned.load(std::memory_order_relaxed);
+                do
+                {
+                    batch.tail->next = expected;
+                } while (!batch.home->m_returned.compare_exchange_weak(expected, batch.head, std::memory_order_release, std::memory_order_relaxed));
+            }
+            batch = OutgoingBatch{};
+        }
+        void flushAll()
+        {
+            for (OutgoingBatch& batch : m_outgoing)
+            {
+                flush(batch);
+            }
+        }
+    };
+
+    // The Registry keeps all the caches, and the caches of exited threads waiting to be adopted. The memory
+    // is released only at the end of the program.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<Cache*> caches;
+        std::vector<Cache*> orphans;
+
+        ~Registry()
+        {
+            for (Cache* const cache : caches)
+            {
+                for (void* const slab : cache->m_slabs)
+                {
+                    ::operator delete(slab, std::align_val_t(SLAB_SIZE));
+                }
+                delete cache;
+            }
+        }
+    };
+    static Registry& registry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // The thread's cache. It is trivially destructible, so it can still be read while the thread_local objects
+    // with destructors are destroyed, in whatever order.
+    struct LocalCache
+    {
+        Cache* cache = nullptr;
+        bool exited = false;
+    };
+
+    // Hands the cache over to the orphans when its thread exits.
+    struct CacheOwner
+    {
+        LocalCache* local;
+
+        ~CacheOwner()
+        {
+            local->cache->flushAll();
+            const std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().orphans.push_back(std::exchange(local->cache, nullptr));
+            local->exited = true;
+        }
+    };
+
+    // Returns nullptr once the thread has given up its cache.
+    static Cache* localCache()
+    {
+        thread_local LocalCache local;
+        if (local.cache == nullptr && !local.exited)
+        {
+            {
+                Registry& caches = registry();
+                const std::lock_guard<std::mutex> lock(caches.mutex);
+                if (caches.orphans.empty())
+                {
+                    local.cache = caches.caches.emplace_back(new Cache);
+                }
+                else
+                {
+                    local.cache = caches.orphans.back();
+                    caches.orphans.pop_back();
+                }
+            }
+            thread_local CacheOwner owner{ &local };
+        }
+        return local.cache;
+    }
+};
+
+// Inheriting from SlabAllocated<T> makes `new T` and `delete` of a T (also through a base class pointer, since the
+// destructors are virtual) use the slab pool of T. Objects of classes derived from T that have another size keep
+// using the general purpose heap.
+template <typename T>
+class SlabAllocated
+{
+public:
+    static void* operator new(const std::size_t size)
+    {
+        return size == sizeof(T) ? SlabPool<T>::allocate() : ::operator new(size);
+    }
+    static void operator delete(void* const pointer, const std::size_t size)
+    {
+        if (size == sizeof(T))
+        {
+            SlabPool<T>::deallocate(pointer);
+        }
+        else
+        {
+            ::operator delete(pointer);
+        }
+    }
+};
+
+// The ProductArray owns products constructed contiguously in a single allocation and destroys them all at once.
+// The products are accessed through their abstract type, so it can be returned from the Abstract Factory interface.
+template <typename AbstractProductT>
+class ProductArray
+{
+public:
+    // The iterators walk the products as their abstract type.
+    template <typename ValueT>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<ValueT>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueT*;
+        using reference = ValueT&;
+
+        Iterator() = default;
+        reference operator*() const { return *m_at(m_storage, m_index); }
+        pointer operator->() const { return m_at(m_storage, m_index); }
+        Iterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++m_index;
+            return previous;
+        }
+        bool operator==(const Iterator& other) const { return m_storage == other.m_storage && m_index == other.m_index; }
+
+    private:
+        friend class ProductArray;
+
+        char* m_storage = nullptr;
+        std::size_t m_index = 0;
+        AbstractProductT* (*m_at)(char*, std::size_t) = nullptr;
+
+        explicit Iterator(char* const storage, const std::size_t index, AbstractProductT* (*const at)(char*, std::size_t))
+            : m_storage(storage)
+            , m_index(index)
+            , m_at(at)
+        { }
+    };
+    using iterator = Iterator<AbstractProductT>;
+    using const_iterator = Iterator<const AbstractProductT>;
+
+    template <typename ConcreteProductT>
+    static ProductArray make(const std::size_t size)
+    {
+        static_assert(alignof(ConcreteProductT) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        if (size > std::numeric_limits<std::size_t>::max() / sizeof(ConcreteProductT))
+        {
+            throw std::bad_array_new_length();
+        }
+        ProductArray array;
+        ConcreteProductT* const products = static_cast<ConcreteProductT*>(::operator new(size * sizeof(ConcreteProductT)));
+        array.m_storage = reinterpret_cast<char*>(products);
+        array.m_at = [](char* const storage, const std::size_t index) -> AbstractProductT*
+        {
+            return reinterpret_cast<ConcreteProductT*>(storage) + index;
+        };
+        array.m_destroy = [](char* const storage, const std::size_t count)
+        {
+            std::destroy_n(reinterpret_cast<ConcreteProductT*>(storage), count);
+        };
+        for (; array.m_size < size; ++array.m_size)
+        {
+            ::new (products + array.m_size) ConcreteProductT();
+        }
+        return array;
+    }
+    ProductArray(ProductArray&& other) noexcept
+        : m_storage(std::exchange(other.m_storage, nullptr))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_at(other.m_at)
+        , m_destroy(other.m_destroy)
+    { }
+    ProductArray& operator=(ProductArray&&) = delete;
+    ~ProductArray()
+    {
+        if (m_storage)
+        {
+            m_destroy(m_storage, m_size);
+            ::operator delete(m_storage);
+        }
+    }
+
+    std::size_t size() const { return m_size; }
+    const AbstractProductT& operator[](const std::size_t index) const { return *m_at(m_storage, index); }
+    AbstractProductT& operator[](const std::size_t index) { return *m_at(m_storage, index); }
+    iterator begin() { return iterator(m_storage, 0, m_at); }
+    iterator end() { return iterator(m_storage, m_size, m_at); }
+    const_iterator begin() const { return const_iterator(m_storage, 0, m_at); }
+    const_iterator end() const { return const_iterator(m_storage, m_size, m_at); }
+
+private:
+    char* m_storage = nullptr;
+    std::size_t m_size = 0;
+    // Converting from the concrete product pointer applies the base class offset, if any.
+    AbstractProductT* (*m_at)(char*, std::size_t) = nullptr;
+    void (*m_destroy)(char*, std::size_t) = nullptr;
+
+    explicit ProductArray() = default;
+};
 
 // Each distinct product of a product family should have a base interface.
 // All variants of the product must implement this interface.
@@ -9,12 +508,12 @@ public:
     virtual ~AbstractProductA() = default;
     virtual std::string usefulFunctionA() const = 0;
 };
-class ConcreteProductA1 : public AbstractProductA
+class ConcreteProductA1 : public AbstractProductA, public SlabAllocated<ConcreteProductA1>
 {
 public:
     std::string usefulFunctionA() const override { return "ConcreteProductA1."; }
 };
-class ConcreteProductA2 : public AbstractProductA
+class ConcreteProductA2 : public AbstractProductA, public SlabAllocated<ConcreteProductA2>
 {
 public:
     std::string usefulFunctionA() const override { return "ConcreteProductA2."; }
@@ -29,12 +528,12 @@ public:
     virtual std::string usefulFunctionB() const = 0;
 };
 // Concrete Products are created by corresponding Concrete Factories.
-class ConcreteProductB1 : public AbstractProductB
+class ConcreteProductB1 : public AbstractProductB, public SlabAllocated<ConcreteProductB1>
 {
 public:
     std::string usefulFunctionB() const override { return "ConcreteProductB1."; }
 };
-class ConcreteProductB2 : public AbstractProductB
+class ConcreteProductB2 : public AbstractProductB, public SlabAllocated<ConcreteProductB2>
 {
 public:
     std::string usefulFunctionB() const override { return "ConcreteProductB2."; }
@@ -44,11 +543,15 @@ public:
 // These products are called a family and are related by a high-level theme or concept. Products of
 // one family are usually able to collaborate among themselves. A family of products may have several
 // variants, but the products of one variant are incompatible with products of another.
+// The products are allocated from the per-type slab pools, and the bulk methods create many products of one kind
+// in a single contiguous allocation.
 class AbstractFactory
 {
 public:
     virtual AbstractProductA* createProductA() const = 0;
     virtual AbstractProductB* createProductB() const = 0;
+    virtual ProductArray<AbstractProductA> createProductsA(std::size_t count) const = 0;
+    virtual ProductArray<AbstractProductB> createProductsB(std::size_t count) const = 0;
 };
 // Concrete Factories produce a family of products that belong to a single variant. The factory guarantees
 // that resulting products are compatible. Note that signatures of the Concrete Factory's methods return
@@ -58,6 +561,14 @@ class ConcreteFactory1 : public AbstractFactory
 public:
     AbstractProductA* createProductA() const override { return new ConcreteProductA1(); }
     AbstractProductB* createProductB() const override { return new ConcreteProductB1(); }
+    ProductArray<AbstractProductA> createProductsA(const std::size_t count) const override
+    {
+        return ProductArray<AbstractProductA>::make<ConcreteProductA1>(count);
+    }
+    ProductArray<AbstractProductB> createProductsB(const std::size_t count) const override
+    {
+        return ProductArray<AbstractProductB>::make<ConcreteProductB1>(count);
+    }
 };
 // Each Concrete Factory has a corresponding product variant.
 class ConcreteFactory2 : public AbstractFactory
@@ -65,8 +576,152 @@ class ConcreteFactory2 : public AbstractFactory
 public:
     AbstractProductA* createProductA() const override { return new ConcreteProductA2(); }
     AbstractProductB* createProductB() const override { return new ConcreteProductB2(); }
+    ProductArray<AbstractProductA> createProductsA(const std::size_t count) const override
+    {
+        return ProductArray<AbstractProductA>::make<ConcreteProductA2>(count);
+    }
+    ProductArray<AbstractProductB> createProductsB(const std::size_t count) const override
+    {
+        return ProductArray<AbstractProductB>::make<ConcreteProductB2>(count);
+    }
+};
+
+// The application picks the product family from configuration strings. The FactoryRegistry maps family names to
+// factories through a perfect hash table that is built at compile time (hash and displace): the name selects a
+// bucket, the bucket's displacement selects the slot, and a single string comparison confirms the match. So a
+// lookup neither allocates nor probes. The factories are singletons, constructed lazily on their first lookup.
+struct FactoryEntry
+{
+    std::string_view name;
+    const AbstractFactory& (*instance)() = nullptr;
+};
+
+template <typename FactoryT>
+const AbstractFactory& lazyInstance()
+{
+    static const FactoryT factory;
+    return factory;
+}
+
+template <std::size_t N>
+class FactoryRegistry
+{
+public:
+    static constexpr std::size_t BUCKET_COUNT = N;
+    static constexpr std::size_t SLOT_COUNT = std::bit_ceil(2 * N);
+
+    // Fails to compile if two entries have the same name, since no perfect hash could tell them apart.
+    consteval explicit FactoryRegistry(const std::array<FactoryEntry, N>& entries)
+    {
+        std::array<std::string_view, N> names{};
+        std::transform(entries.begin(), entries.end(), names.begin(), [](const FactoryEntry& entry) { return entry.name; });
+        std::sort(names.begin(), names.end());
+        if (std::adjacent_find(names.begin(), names.end()) != names.end())
+        {
+            throw "FactoryRegistry: duplicate family name";
+        }
+
+        std::array<std::uint64_t, N> hashes{};
+        std::array<std::size_t, BUCKET_COUNT> bucketSizes{};
+        for (std::size_t index = 0; index < N; ++index)
+        {
+            hashes[index] = hash(entries[index].name);
+            ++bucketSizes[bucketOf(hashes[index])];
+        }
+        // The entries are grouped by bucket, and the largest buckets are placed first, while most of the slots
+        // are still free.
+        std::array<std::size_t, N> order{};
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        std::sort(order.begin(), order.end(), [&](const std::size_t lhs, const std::size_t rhs)
+        {
+            const std::size_t lhsBucket = bucketOf(hashes[lhs]);
+            const std::size_t rhsBucket = bucketOf(hashes[rhs]);
+            return bucketSizes[lhsBucket] != bucketSizes[rhsBucket] ? bucketSizes[lhsBucket] > bucketSizes[rhsBucket] : lhsBucket < rhsBucket;
+        });
+
+        std::array<bool, SLOT_COUNT> used{};
+        for (std::size_t begin = 0; begin < N; begin += bucketSizes[bucketOf(hashes[order[begin]])])
+        {
+            const std::size_t bucket = bucketOf(hashes[order[begin]]);
+            const std::span<const std::size_t> members(order.data() + begin, bucketSizes[bucket]);
+            m_displacements[bucket] = placeBucket(entries, hashes, members, used);
+        }
+    }
+
+    // The name is hashed once: the bucket and the slot both derive from the same hash.
+    const AbstractFactory* find(const std::string_view name) const
+    {
+        const std::uint64_t nameHash = hash(name);
+        const FactoryEntry& entry = m_slots[slotOf(nameHash, m_displacements[bucketOf(nameHash)])];
+        return entry.instance != nullptr && entry.name == name ? &entry.instance() : nullptr;
+    }
+
+private:
+    std::array<std::uint64_t, BUCKET_COUNT> m_displacements{};
+    std::array<FactoryEntry, SLOT_COUNT> m_slots{};
+
+    // FNV-1a, with a final mix that spreads the last characters over all the bits: names that differ only at
+    // the end, like "Family1" and "Family2", would otherwise share their high bits and their bucket.
+    static constexpr std::uint64_t hash(const std::string_view name)
+    {
+        std::uint64_t value = 14695981039346656037ull;
+        for (const char c : name)
+        {
+            value = (value ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return mix(value);
+    }
+    static constexpr std::uint64_t mix(std::uint64_t value)
+    {
+        value = (value ^ (value >> 31)) * 0xBF58476D1CE4E5B9ull;
+        return value ^ (value >> 29);
+    }
+    // The high half of the hash is mapped onto the buckets by a multiplication instead of a division.
+    static constexpr std::size_t bucketOf(const std::uint64_t nameHash)
+    {
+        return static_cast<std::size_t>(((nameHash >> 32) * BUCKET_COUNT) >> 32);
+    }
+    static constexpr std::size_t slotOf(const std::uint64_t nameHash, const std::uint64_t displacement)
+    {
+        return static_cast<std::size_t>(mix(nameHash ^ (displacement * 0x9E3779B97F4A7C15ull))) & (SLOT_COUNT - 1);
+    }
+
+    // Finds a displacement that sends all the members of a bucket to distinct free slots, and takes those slots.
+    constexpr std::uint64_t placeBucket(const std::array<FactoryEntry, N>& entries, const std::array<std::uint64_t, N>& hashes,
+                                        const std::span<const std::size_t> members, std::array<bool, SLOT_COUNT>& used)
+    {
+        for (std::uint64_t displacement = 1; displacement < (1u << 20); ++displacement)
+        {
+            bool fits = true;
+            for (std::size_t member = 0; member < members.size() && fits; ++member)
+            {
+                const std::size_t slot = slotOf(hashes[members[member]], displacement);
+                fits = !used[slot];
+                for (std::size_t previous = 0; previous < member && fits; ++previous)
+                {
+                    fits = slotOf(hashes[members[previous]], displacement) != slot;
+                }
+            }
+            if (fits)
+            {
+                for (const std::size_t member : members)
+                {
+                    const std::size_t slot = slotOf(hashes[member], displacement);
+                    m_slots[slot] = entries[member];
+                    used[slot] = true;
+                }
+                return displacement;
+            }
+        }
+        throw "FactoryRegistry: no perfect hash found";
+    }
 };
 
+constexpr FactoryRegistry FACTORY_REGISTRY(std::array{
+    FactoryEntry{ "Variant1", &lazyInstance<ConcreteFactory1> },
+    FactoryEntry{ "Variant2", &lazyInstance<ConcreteFactory2> }
+});
+
 // The client code works with factories and products only through abstract types: AbstractFactory and AbstractProduct.
 // This lets you pass any factory or product subclass to the client code without breaking it.
 void clientCode(const AbstractFactory& factory)
@@ -79,14 +734,92 @@ void clientCode(const AbstractFactory& factory)
     delete abstractProductB;
 }
 
+// Products that are needed in bulk can be created in one go.
+void bulkClientCode(const AbstractFactory& factory)
+{
+    const ProductArray<AbstractProductA> productsA = factory.createProductsA(3);
+    for (const AbstractProductA& productA : productsA)
+    {
+        std::cout << productA.usefulFunctionA() << ' ';
+    }
+    std::cout << '\n';
+}
+
+// Products often die on another thread than the one that made them. The consumer's frees go back to the producer's
+// slab cache in batches, and whatever is left in them is sent home when the consumer thread exits.
+std::size_t producerConsumerClientCode(const AbstractFactory& factory, const std::size_t count)
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<AbstractProductA*> handedOver;
+    bool done = false;
+    std::size_t consumed = 0;
+    std::thread consumer([&]
+    {
+        std::vector<AbstractProductA*> products;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return done || !handedOver.empty(); });
+                if (handedOver.empty())
+                {
+                    return;
+                }
+                products.swap(handedOver);
+            }
+            for (AbstractProductA* const product : products)
+            {
+                consumed += product->usefulFunctionA().size() != 0;
+                delete product;
+            }
+            products.clear();
+        }
+    });
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        AbstractProductA* const product = factory.createProductA();
+        const std::lock_guard<std::mutex> lock(mutex);
+        handedOver.push_back(product);
+        ready.notify_one();
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    ready.notify_one();
+    consumer.join();
+    return consumed;
+}
+
 int main()
 {
     std::cout << "Client: Testing client code with the first factory type:\n";
     const ConcreteFactory1* const f1 = new ConcreteFactory1();
     clientCode(*f1);
+    std::cout << "Client: Testing bulk creation with the first factory type:\n";
+    bulkClientCode(*f1);
     delete f1;
     std::cout << "\nClient: Testing client code with the second factory type:\n";
     const ConcreteFactory2* const f2 = new ConcreteFactory2();
     clientCode(*f2);
+    std::cout << "Client: Testing bulk creation with the second factory type:\n";
+    bulkClientCode(*f2);
     delete f2;
+
+    for (const std::string_view family : { "Variant2", "Variant3" })
+    {
+        std::cout << "\nClient: Testing client code with the factory configured as \"" << family << "\":\n";
+        if (const AbstractFactory* const factory = FACTORY_REGISTRY.find(family))
+        {
+            clientCode(*factory);
+        }
+        else
+        {
+            std::cout << "There is no such product family.\n";
+        }
+    }
+
+    std::cout << "\nClient: Testing products made on one thread and deleted on another:\n";
+    std::cout << producerConsumerClientCode(ConcreteFactory1(), 100'000) << " products were handed over.\n";
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+// A benchmark of the StreamingBuilder of Builder_Conceptual_Example.cpp against building every product with the
+// ConcreteBuilder1 and printing it with Product1::listParts. Both write the same products to a temporary file, and
+// the two files are compared. The example is compiled in, with its main() renamed.
+//     g++ -std=c++20 -O2 Builder_Benchmark.cpp -o Builder_Benchmark
+//     ./Builder_Benchmark [product count]
+// The benchmark exits with a non-zero status if the two outputs differ.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main builderExampleMain
+#include "Builder_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+
+// Every third product is a minimal one, so the products don't all have the same size.
+template <typename BuildOne>
+void buildProducts(const Director& director, const std::size_t productCount, BuildOne&& buildOne)
+{
+    for (std::size_t i = 0; i < productCount; ++i)
+    {
+        if (i % 3 == 0)
+        {
+            director.buildMinimalViableProduct();
+        }
+        else
+        {
+            director.buildFullFeaturedProduct();
+        }
+        buildOne();
+    }
+}
+
+double buildThenPrint(Director& director, const std::size_t productCount, const char* const path)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::streambuf* const coutBuffer = std::cout.rdbuf(file.rdbuf());
+    const auto start = std::chrono::steady_clock::now();
+    ConcreteBuilder1 builder;
+    director.setBuilder(&builder);
+    buildProducts(director, productCount, [&builder]
+    {
+        const Product1* const product = builder.getProduct();
+        product->listParts();
+        delete product;
+    });
+    std::cout.flush();
+    const auto end = std::chrono::steady_clock::now();
+    std::cout.rdbuf(coutBuffer);
+    return std::chrono::duration<double>(end - start).count();
+}
+
+double streaming(Director& director, const std::size_t productCount, const char* const path)
+{
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "open");
+    }
+    const auto start = std::chrono::steady_clock::now();
+    {
+        const StreamingBuilder builder(fd);
+        director.setBuilder(&builder);
+        buildProducts(director, productCount, [&builder] { builder.finishProduct(); });
+        builder.flush();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    close(fd);
+    return std::chrono::duration<double>(end - start).count();
+}
+
+std::string readFile(const char* const path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t productCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    const char* const printedPath = "Builder_Benchmark.printed.tmp";
+    const char* const streamedPath = "Builder_Benchmark.streamed.tmp";
+
+    Director director;
+    const double printedSeconds = buildThenPrint(director, productCount, printedPath);
+    const double streamedSeconds = streaming(director, productCount, streamedPath);
+    const std::string printed = readFile(printedPath);
+    const std::string streamed = readFile(streamedPath);
+    std::remove(printedPath);
+    std::remove(streamedPath);
+    if (printed != streamed)
+    {
+        std::cout << "FAILED: the streamed output differs from the printed one.\n";
+        return 1;
+    }
+
+    const double megabytes = static_cast<double>(streamed.size()) / (1024.0 * 1024.0);
+    std::cout << productCount << " products, " << static_cast<std::uint64_t>(megabytes) << " MiB of output.\n";
+    std::cout << "builder           products/s   MiB/s\n";
+    for (const auto& [name, seconds] : { std::pair{ "build then print", printedSeconds }, std::pair{ "streaming       ", streamedSeconds } })
+    {
+        std::cout << name << "  " << static_cast<std::uint64_t>(productCount / seconds) << "     "
+                  << static_cast<std::uint64_t>(megabytes / seconds) << '\n';
+    }
+}
@@ -1,7 +1,20 @@
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <unistd.h>
+
 // It makes sense to use the Builder pattern only when your products are quite complex and require extensive configuration.
 // Unlike in other creational patterns, different concrete builders can produce unrelated products. In other words,
 // results of various builders may not always follow the same interface.
@@ -54,6 +67,243 @@ public:
     }
 };
 
+// Products that are assembled from a small set of well-known parts don't need a string per part. The part
+// catalogue interns each part name once and hands out a compact ID, which is all that the products store.
+using PartId = std::uint32_t;
+
+class PartCatalogue
+{
+private:
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, PartId> m_ids;
+
+public:
+    PartId intern(const std::string& name)
+    {
+        const auto [it, inserted] = m_ids.try_emplace(name, static_cast<PartId>(m_names.size()));
+        if (inserted)
+        {
+            m_names.push_back(name);
+        }
+        return it->second;
+    }
+    const std::string& name(const PartId id) const { return m_names[id]; }
+};
+
+// The arena keeps the parts of all its products back to back in one vector; a product is the range of parts
+// between the end of the previous product and its own end. Reserving up front makes a bulk build allocate
+// only twice, however many products it assembles.
+class ProductArena
+{
+private:
+    std::vector<PartId> m_parts;
+    std::vector<std::size_t> m_ends;
+
+public:
+    void reserve(const std::size_t productCount, const std::size_t partsPerProduct)
+    {
+        m_parts.reserve(m_parts.size() + productCount * partsPerProduct);
+        m_ends.reserve(m_ends.size() + productCount);
+    }
+    void addPart(const PartId part) { m_parts.push_back(part); }
+    void finishProduct() { m_ends.push_back(m_parts.size()); }
+
+    std::size_t size() const { return m_ends.size(); }
+    std::span<const PartId> parts(const std::size_t product) const
+    {
+        const std::size_t begin = product == 0 ? 0 : m_ends[product - 1];
+        return std::span<const PartId>(m_parts).subspan(begin, m_ends[product] - begin);
+    }
+    void listParts(const std::size_t product, const PartCatalogue& catalogue) const
+    {
+        std::cout << "Product parts: ";
+        for (const PartId part : parts(product))
+        {
+            std::cout << catalogue.name(part) << ", ";
+        }
+        std::cout << "\n\n";
+    }
+};
+
+// This builder produces the same parts as ConcreteBuilder1, but appends their IDs to an arena instead of
+// creating a new product object for every build.
+class InterningBuilder : public Builder
+{
+private:
+    ProductArena& m_arena;
+    PartId m_partA;
+    PartId m_partB;
+    PartId m_partC;
+
+public:
+    explicit InterningBuilder(PartCatalogue& catalogue, ProductArena& arena)
+        : m_arena(arena)
+        , m_partA(catalogue.intern("PartA1"))
+        , m_partB(catalogue.intern("PartB1"))
+        , m_partC(catalogue.intern("PartC1"))
+    { }
+    void producePartA() const override { m_arena.addPart(m_partA); }
+    void producePartB() const override { m_arena.addPart(m_partB); }
+    void producePartC() const override { m_arena.addPart(m_partC); }
+    void reserve(const std::size_t productCount, const std::size_t partsPerProduct) const
+    {
+        m_arena.reserve(productCount, partsPerProduct);
+    }
+    // Closes the product whose parts were produced since the previous call.
+    void finishProduct() const { m_arena.finishProduct(); }
+};
+
+// Products that are built only to be written out don't need to exist as objects. The streaming builder serializes
+// every part as it is produced, in the format of Product1::listParts, into a reusable output buffer, and writes the
+// buffer out with a single write call whenever it is full. So the output costs one syscall per BUFFER_SIZE bytes,
+// however small the parts are.
+class StreamingBuilder : public Builder
+{
+private:
+    static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+    static constexpr std::string_view PREFIX = "Product parts: ";
+    static constexpr std::string_view SEPARATOR = ", ";
+    static constexpr std::string_view SUFFIX = "\n\n";
+
+    int m_fd;
+    mutable std::vector<char> m_buffer;
+    mutable std::size_t m_used;
+    mutable bool m_productStarted;
+
+    void append(const std::string_view text) const
+    {
+        if (text.size() > BUFFER_SIZE - m_used)
+        {
+            flush();
+            if (text.size() > BUFFER_SIZE)
+            {
+                if (!writeAll(text.data(), text.size()))
+                {
+                    throw std::system_error(errno, std::generic_category(), "write");
+                }
+                return;
+            }
+        }
+        std::memcpy(m_buffer.data() + m_used, text.data(), text.size());
+        m_used += text.size();
+    }
+    void appendPart(const std::string_view part) const
+    {
+        if (!m_productStarted)
+        {
+            append(PREFIX);
+            m_productStarted = true;
+        }
+        append(part);
+        append(SEPARATOR);
+    }
+    // Returns false if writing failed.
+    bool writeAll(const char* data, std::size_t size) const
+    {
+        while (size > 0)
+        {
+            const ssize_t written = write(m_fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+    // Returns false if writing failed; the buffered output is dropped either way.
+    bool writePending() const
+    {
+        const std::size_t used = std::exchange(m_used, 0);
+        return writeAll(m_buffer.data(), used);
+    }
+
+public:
+    explicit StreamingBuilder(const int fd)
+        : m_fd(fd)
+        , m_buffer(BUFFER_SIZE)
+        , m_used(0)
+        , m_productStarted(false)
+    { }
+    ~StreamingBuilder() { writePending(); }
+    StreamingBuilder(const StreamingBuilder&) = delete;
+    StreamingBuilder& operator=(const StreamingBuilder&) = delete;
+
+    void producePartA() const override { appendPart("PartA1"); }
+    void producePartB() const override { appendPart("PartB1"); }
+    void producePartC() const override { appendPart("PartC1"); }
+    // Ends the product whose parts were produced since the previous call.
+    void finishProduct() const
+    {
+        if (!m_productStarted)
+        {
+            append(PREFIX);
+        }
+        append(SUFFIX);
+        m_productStarted = false;
+    }
+    void flush() const
+    {
+        if (!writePending())
+        {
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+    }
+};
+
+// Configurations that are known at build time can be assembled by the compiler. The constexpr builder has the
+// same steps as the runtime builders, but fills a fixed-capacity product of string views without virtual calls,
+// so the finished product is plain read-only data.
+class ConstexprProduct
+{
+public:
+    static constexpr std::size_t MAX_PARTS = 8;
+
+    std::array<std::string_view, MAX_PARTS> m_parts{};
+    std::size_t m_partCount = 0;
+
+    void listParts() const
+    {
+        std::cout << "Product parts: ";
+        for (std::size_t i = 0; i < m_partCount; ++i)
+        {
+            std::cout << m_parts[i] << ", ";
+        }
+        std::cout << "\n\n";
+    }
+};
+
+class ConstexprBuilder
+{
+private:
+    ConstexprProduct m_product;
+
+    constexpr void addPart(const std::string_view part)
+    {
+        if (m_product.m_partCount == ConstexprProduct::MAX_PARTS)
+        {
+            throw std::length_error("ConstexprBuilder: too many parts");
+        }
+        m_product.m_parts[m_product.m_partCount++] = part;
+    }
+
+public:
+    constexpr ConstexprBuilder() = default;
+    // Continues building from an existing product, e.g. to customize a prebuilt configuration at runtime.
+    constexpr explicit ConstexprBuilder(const ConstexprProduct& product)
+        : m_product(product)
+    { }
+    constexpr void producePartA() { addPart("PartA1"); }
+    constexpr void producePartB() { addPart("PartB1"); }
+    constexpr void producePartC() { addPart("PartC1"); }
+    constexpr ConstexprProduct getProduct() const { return m_product; }
+};
+
 // The Director is only responsible for executing the building steps in a particular sequence.
 // It is helpful when producing products according to a specific order or configuration. Strictly
 // speaking, the Director class is optional, since the client can control builders directly.
@@ -68,15 +318,69 @@ public:
     void setBuilder(const Builder* const builder) { m_builder = builder; }
 
     // The Director can construct several product variations using the same building steps.
-    void buildMinimalViableProduct() const { m_builder->producePartA(); }
-    void buildFullFeaturedProduct() const
+    void buildMinimalViableProduct() const { buildMinimalViableProduct(*m_builder); }
+    void buildFullFeaturedProduct() const { buildFullFeaturedProduct(*m_builder); }
+
+    // The building sequences themselves work with any builder type, including the constexpr one.
+    template <typename BuilderT>
+    static constexpr void buildMinimalViableProduct(BuilderT& builder)
+    {
+        builder.producePartA();
+    }
+    template <typename BuilderT>
+    static constexpr void buildFullFeaturedProduct(BuilderT& builder)
+    {
+        builder.producePartA();
+        builder.producePartB();
+        builder.producePartC();
+    }
+
+    // In the bulk mode, the Director assembles a whole batch of full featured products in a single pass. The bulk
+    // builder reserves room for the whole batch up front and is told where each product ends.
+    template <typename BulkBuilderT>
+    static void buildFullFeaturedProducts(BulkBuilderT& builder, const std::size_t count)
+    {
+        constexpr std::size_t partsPerProduct = countParts([](PartCounter& counter) { buildFullFeaturedProduct(counter); });
+        builder.reserve(count, partsPerProduct);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            buildFullFeaturedProduct(builder);
+            builder.finishProduct();
+        }
+    }
+
+private:
+    // Counts the parts that a building sequence produces, without building anything.
+    struct PartCounter
+    {
+        std::size_t m_count = 0;
+
+        constexpr void producePartA() { ++m_count; }
+        constexpr void producePartB() { ++m_count; }
+        constexpr void producePartC() { ++m_count; }
+    };
+    template <typename Sequence>
+    static constexpr std::size_t countParts(const Sequence& sequence)
     {
-        m_builder->producePartA();
-        m_builder->producePartB();
-        m_builder->producePartC();
+        PartCounter counter;
+        sequence(counter);
+        return counter.m_count;
     }
 };
 
+// The fixed configurations are built once, during compilation.
+inline constexpr ConstexprProduct MINIMAL_VIABLE_PRODUCT = [] {
+    ConstexprBuilder builder;
+    Director::buildMinimalViableProduct(builder);
+    return builder.getProduct();
+}();
+inline constexpr ConstexprProduct FULL_FEATURED_PRODUCT = [] {
+    ConstexprBuilder builder;
+    Director::buildFullFeaturedProduct(builder);
+    return builder.getProduct();
+}();
+static_assert(FULL_FEATURED_PRODUCT.m_partCount == 3);
+
 // The client code creates a builder object, passes it to the director and then initiates
 // the construction process. The end result is retrieved from the builder object.
 void clientCode(Director& director)
@@ -106,9 +410,55 @@ void clientCode(Director& director)
     delete builder;
 }
 
+// The prebuilt products need no building at all, and the remaining variants start from them at runtime.
+void constexprClientCode()
+{
+    std::cout << "Prebuilt basic product:\n";
+    MINIMAL_VIABLE_PRODUCT.listParts();
+    std::cout << "Prebuilt full featured product:\n";
+    FULL_FEATURED_PRODUCT.listParts();
+
+    std::cout << "Customized prebuilt product:\n";
+    ConstexprBuilder builder(MINIMAL_VIABLE_PRODUCT);
+    builder.producePartC();
+    builder.getProduct().listParts();
+}
+
+// In bulk, the client code gets a whole arena of products back instead of one object per product.
+void bulkClientCode(const Director& director)
+{
+    PartCatalogue catalogue;
+    ProductArena arena;
+    const InterningBuilder builder(catalogue, arena);
+
+    std::cout << "Bulk full featured products:\n";
+    director.buildFullFeaturedProducts(builder, 1000);
+    std::cout << "Assembled " << arena.size() << " products, the last one:\n";
+    arena.listParts(arena.size() - 1, catalogue);
+}
+
+// The streamed products go straight to the output, and the client code never gets them back.
+void streamingClientCode(Director& director)
+{
+    std::cout << "Streamed products:\n" << std::flush;
+    const StreamingBuilder builder(STDOUT_FILENO);
+    director.setBuilder(&builder);
+    director.buildMinimalViableProduct();
+    builder.finishProduct();
+    for (int i = 0; i < 2; ++i)
+    {
+        director.buildFullFeaturedProduct();
+        builder.finishProduct();
+    }
+    builder.flush();
+}
+
 int main()
 {
     Director* const director = new Director();
     clientCode(*director);
+    constexprClientCode();
+    bulkClientCode(*director);
+    streamingClientCode(*director);
     delete director;
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
+#include <cstddef>
 #include <iostream>
+#include <new>
 #include <string>
+#include <utility>
 
 // The Product interface declares the operations that all concrete products must implement.
 class Product
@@ -7,6 +10,9 @@ class Product
 public:
     virtual ~Product() = default;
     virtual std::string operation() const = 0;
+    // Appends the result of the operation to a buffer owned by the caller. Products whose result is known up front
+    // override it to append without allocating.
+    virtual void appendOperation(std::string& result) const { result += operation(); }
 };
 
 // Concrete Products provide various implementations of the Product interface.
@@ -14,12 +20,50 @@ class ConcreteProduct1 : public Product
 {
 public:
     std::string operation() const override { return "{Result of the ConcreteProduct1}"; }
+    void appendOperation(std::string& result) const override { result += "{Result of the ConcreteProduct1}"; }
 };
 
 class ConcreteProduct2 : public Product
 {
 public:
     std::string operation() const override { return "{Result of the ConcreteProduct2}"; }
+    void appendOperation(std::string& result) const override { result += "{Result of the ConcreteProduct2}"; }
+};
+
+// The slot is storage that the caller provides for the emplacing factory method. It can hold any product that
+// fits into MAX_SIZE bytes and destroys the product it holds.
+class ProductSlot
+{
+public:
+    static constexpr std::size_t MAX_SIZE = 32;
+
+    ProductSlot() = default;
+    ~ProductSlot() { reset(); }
+    ProductSlot(const ProductSlot&) = delete;
+    ProductSlot& operator=(const ProductSlot&) = delete;
+
+    template <typename ProductT, typename... Args>
+    ProductT* emplace(Args&&... args)
+    {
+        static_assert(sizeof(ProductT) <= MAX_SIZE, "The product does not fit into the slot");
+        static_assert(alignof(ProductT) <= alignof(std::max_align_t), "The product is overaligned");
+        reset();
+        ProductT* const product = new (m_storage) ProductT(std::forward<Args>(args)...);
+        m_product = product;
+        return product;
+    }
+    void reset()
+    {
+        if (m_product != nullptr)
+        {
+            m_product->~Product();
+            m_product = nullptr;
+        }
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_storage[MAX_SIZE];
+    Product* m_product = nullptr;
 };
 
 // The Creator class declares the factory method that is supposed to return an object of a Product class.
@@ -30,6 +74,8 @@ class Creator
 public:
     virtual ~Creator() = default;
     virtual Product* factoryMethod() const = 0;
+    // The emplacing factory method constructs the product in the caller's slot instead of on the heap.
+    virtual Product* emplaceProduct(ProductSlot& slot) const = 0;
 
     std::string someOperation() const
     {
@@ -38,6 +84,15 @@ public:
         delete product;
         return result;
     }
+    // Formats the result into a buffer that the caller reuses. Once the buffer has grown large enough,
+    // the call doesn't allocate at all.
+    void someOperation(std::string& result) const
+    {
+        ProductSlot slot;
+        const Product* const product = emplaceProduct(slot);
+        result.assign("Creator: The same creator's code has just worked with ");
+        product->appendOperation(result);
+    }
 };
 
 // Concrete Creators override the factory method in order to change the resulting product's type.
@@ -47,12 +102,14 @@ class ConcreteCreator1 : public Creator
 // is actually returned from the method. This way the Creator can stay independent of concrete product classes.
 public:
     Product* factoryMethod() const override { return new ConcreteProduct1(); }
+    Product* emplaceProduct(ProductSlot& slot) const override { return slot.emplace<ConcreteProduct1>(); }
 };
 
 class ConcreteCreator2 : public Creator
 {
 public:
     Product* factoryMethod() const override { return new ConcreteProduct2(); }
+    Product* emplaceProduct(ProductSlot& slot) const override { return slot.emplace<ConcreteProduct2>(); }
 };
 
 // The client code works with an instance of a concrete creator, albeit through its base interface. As long as
@@ -63,6 +120,13 @@ void clientCode(const Creator& creator)
               << creator.someOperation() << std::endl;
 }
 
+// The same, but with a buffer that the client code reuses for every call.
+void clientCode(const Creator& creator, std::string& buffer)
+{
+    creator.someOperation(buffer);
+    std::cout << "Client: I'm reusing my buffer, and it still works.\n" << buffer << std::endl;
+}
+
 // The Application picks a creator's type depending on the configuration or environment.
 int main()
 {
@@ -73,6 +137,11 @@ int main()
     const Creator* const creator2 = new ConcreteCreator2();
     clientCode(*creator2);
 
+    std::cout << "\nApp: Reusing one result buffer with both creators.\n";
+    std::string buffer;
+    clientCode(*creator1, buffer);
+    clientCode(*creator2, buffer);
+
     delete creator1;
     delete creator2;
 }
\ No newline at end of file
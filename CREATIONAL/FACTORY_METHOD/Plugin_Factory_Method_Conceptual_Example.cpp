@@ -0,0 +1,195 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <dlfcn.h>
+
+// When there are hundreds of Concrete Creators, linking all of them into the application makes it start slower
+// and use more memory than it needs for the few creators it actually uses. Here every creator and its product
+// live in a plugin, a shared library that is loaded on first use. A prebuilt manifest maps the creator names to
+// the plugin files, so nothing is probed or loaded at startup.
+//
+// The same file builds both sides. A plugin is built with FACTORY_METHOD_PLUGIN set to its name:
+//     g++ -std=c++20 -shared -fPIC -DFACTORY_METHOD_PLUGIN='"Creator1"' Plugin_Factory_Method_Conceptual_Example.cpp -o creator1.so
+// and the application without it:
+//     g++ -std=c++20 Plugin_Factory_Method_Conceptual_Example.cpp -o app -ldl
+// The manifest lists one plugin per line, as its name and the path of its library:
+//     Creator1 ./creator1.so
+// The application is then started as:
+//     ./app manifest.txt Creator1
+
+// The Product interface declares the operations that all concrete products must implement.
+class Product
+{
+public:
+    virtual ~Product() = default;
+    virtual std::string operation() const = 0;
+};
+
+// The Creator class declares the factory method that is supposed to return an object of a Product class.
+class Creator
+{
+public:
+    virtual ~Creator() = default;
+    virtual Product* factoryMethod() const = 0;
+
+    std::string someOperation() const
+    {
+        const Product* const product = factoryMethod();
+        const std::string result = "Creator: The same creator's code has just worked with " + product->operation();
+        delete product;
+        return result;
+    }
+};
+
+// Every plugin exports a function with this name, which returns the plugin's creator. The creator is owned
+// by the plugin and stays valid until the plugin is unloaded.
+using PluginEntryPoint = const Creator* (*)();
+inline constexpr const char* PLUGIN_ENTRY_POINT = "factoryMethodPluginCreator";
+
+#ifdef FACTORY_METHOD_PLUGIN
+
+// The Concrete Creator and Concrete Product of one plugin.
+class PluginProduct : public Product
+{
+public:
+    std::string operation() const override { return "{Result of the " FACTORY_METHOD_PLUGIN " product}"; }
+};
+
+class PluginCreator : public Creator
+{
+public:
+    Product* factoryMethod() const override { return new PluginProduct(); }
+};
+
+extern "C" const Creator* factoryMethodPluginCreator()
+{
+    static const PluginCreator creator;
+    return &creator;
+}
+
+#else
+
+// The registry reads the manifest up front, but loads a plugin only when its creator is first asked for.
+// The resolved creator is cached, and the plugins stay loaded until the registry is destroyed.
+class PluginCreatorRegistry
+{
+private:
+    struct Plugin
+    {
+        std::string m_path;
+        std::unique_ptr<void, int (*)(void*)> m_handle{ nullptr, dlclose };
+        const Creator* m_creator = nullptr;
+    };
+
+    std::unordered_map<std::string, Plugin> m_plugins;
+    std::mutex m_mutex;
+
+    static void load(Plugin& plugin)
+    {
+        plugin.m_handle.reset(dlopen(plugin.m_path.c_str(), RTLD_NOW | RTLD_LOCAL));
+        if (!plugin.m_handle)
+        {
+            throw std::runtime_error(std::string("Cannot load a plugin: ") + dlerror());
+        }
+        const auto entryPoint = reinterpret_cast<PluginEntryPoint>(dlsym(plugin.m_handle.get(), PLUGIN_ENTRY_POINT));
+        if (entryPoint == nullptr)
+        {
+            throw std::runtime_error("Plugin " + plugin.m_path + " has no " + PLUGIN_ENTRY_POINT + " entry point");
+        }
+        plugin.m_creator = entryPoint();
+    }
+
+public:
+    // Empty lines and lines that start with '#' are skipped.
+    explicit PluginCreatorRegistry(const std::string& manifestPath)
+    {
+        std::ifstream manifest(manifestPath);
+        if (!manifest)
+        {
+            throw std::runtime_error("Cannot open the plugin manifest " + manifestPath);
+        }
+        std::string line;
+        while (std::getline(manifest, line))
+        {
+            std::istringstream fields(line);
+            std::string name;
+            std::string path;
+            if (!(fields >> name) || name.front() == '#')
+            {
+                continue;
+            }
+            if (!(fields >> path))
+            {
+                throw std::runtime_error("Plugin " + name + " has no library in the manifest");
+            }
+            m_plugins[name].m_path = path;
+        }
+    }
+    PluginCreatorRegistry(const PluginCreatorRegistry&) = delete;
+    PluginCreatorRegistry& operator=(const PluginCreatorRegistry&) = delete;
+
+    // Returns nullptr if the manifest has no such creator, and throws if its plugin cannot be loaded.
+    const Creator* find(const std::string& name)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_plugins.find(name);
+        if (it == m_plugins.end())
+        {
+            return nullptr;
+        }
+        if (it->second.m_creator == nullptr)
+        {
+            load(it->second);
+        }
+        return it->second.m_creator;
+    }
+};
+
+// The client code works with an instance of a concrete creator through its base interface, and doesn't know
+// that the creator comes from a plugin.
+void clientCode(const Creator& creator)
+{
+    std::cout << "Client: I'm not aware of the creator's class, but it still works.\n"
+              << creator.someOperation() << std::endl;
+}
+
+// The Application picks the creators by name from the command line.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <manifest> [creator...]\n";
+        return 1;
+    }
+    try
+    {
+        PluginCreatorRegistry registry(argv[1]);
+        for (int i = 2; i < argc; ++i)
+        {
+            std::cout << "App: Launched with the " << argv[i] << ".\n";
+            if (const Creator* const creator = registry.find(argv[i]))
+            {
+                clientCode(*creator);
+            }
+            else
+            {
+                std::cout << "There is no such creator.\n";
+            }
+            std::cout << '\n';
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+}
+
+#endif
@@ -0,0 +1,118 @@
+// A test of the PluginCreatorRegistry of Plugin_Factory_Method_Conceptual_Example.cpp against two real plugins.
+// The application side of the example is compiled in, with its main() renamed. The plugins are built from the
+// example and passed as arguments:
+//     g++ -std=c++20 -shared -fPIC -DFACTORY_METHOD_PLUGIN='"Creator1"' Plugin_Factory_Method_Conceptual_Example.cpp -o creator1.so
+//     g++ -std=c++20 -shared -fPIC -DFACTORY_METHOD_PLUGIN='"Creator2"' Plugin_Factory_Method_Conceptual_Example.cpp -o creator2.so
+//     g++ -std=c++20 -pthread Plugin_Factory_Method_Test.cpp -o Plugin_Factory_Method_Test -ldl
+//     ./Plugin_Factory_Method_Test ./creator1.so ./creator2.so
+// The test exits with a non-zero status if a check fails.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main pluginExampleMain
+#include "Plugin_Factory_Method_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+int g_failureCount = 0;
+
+void check(const bool condition, const std::string_view what)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << what << '\n';
+        ++g_failureCount;
+    }
+}
+
+template <typename Func>
+bool throwsRuntimeError(Func&& func)
+{
+    try
+    {
+        func();
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+void writeManifest(const std::string& path, const std::string& contents)
+{
+    std::ofstream manifest(path, std::ios::trunc);
+    manifest << contents;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <Creator1 plugin> <Creator2 plugin>\n";
+        return 1;
+    }
+    const std::string creator1Path = std::filesystem::absolute(argv[1]).string();
+    const std::string creator2Path = std::filesystem::absolute(argv[2]).string();
+    const std::string manifestPath = (std::filesystem::temp_directory_path() / "Plugin_Factory_Method_Test.manifest").string();
+
+    writeManifest(manifestPath, "# Test plugins\n"
+                                "\n"
+                                "Creator1 " + creator1Path + "\n"
+                                "Creator2 " + creator2Path + "\n"
+                                "Missing " + creator1Path + ".missing\n");
+    {
+        PluginCreatorRegistry registry(manifestPath);
+
+        const Creator* const creator1 = registry.find("Creator1");
+        const Creator* const creator2 = registry.find("Creator2");
+        check(creator1 != nullptr && creator2 != nullptr, "the creators of the manifest are found");
+        if (creator1 != nullptr && creator2 != nullptr)
+        {
+            check(creator1->someOperation().ends_with("{Result of the Creator1 product}"), "Creator1 makes its own product");
+            check(creator2->someOperation().ends_with("{Result of the Creator2 product}"), "Creator2 makes its own product");
+        }
+        check(registry.find("Creator1") == creator1, "the creator is cached after the first lookup");
+
+        check(registry.find("Creator3") == nullptr, "a name missing from the manifest finds nothing");
+        check(registry.find("#") == nullptr, "comment lines are skipped");
+        check(throwsRuntimeError([&registry] { registry.find("Missing"); }), "a missing library throws");
+        check(throwsRuntimeError([&registry] { registry.find("Missing"); }), "a missing library throws again on retry");
+
+        // Concurrent first lookups of the same creator must all get the one that was loaded.
+        PluginCreatorRegistry concurrentRegistry(manifestPath);
+        std::array<const Creator*, 8> found{};
+        std::vector<std::thread> threads;
+        for (const Creator*& result : found)
+        {
+            threads.emplace_back([&concurrentRegistry, &result] { result = concurrentRegistry.find("Creator2"); });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        for (const Creator* const result : found)
+        {
+            check(result != nullptr && result == found.front(), "concurrent lookups get the same creator");
+        }
+    }
+
+    writeManifest(manifestPath, "Creator1\n");
+    check(throwsRuntimeError([&manifestPath] { PluginCreatorRegistry registry(manifestPath); }),
+          "a manifest line without a library throws");
+    std::remove(manifestPath.c_str());
+    check(throwsRuntimeError([&manifestPath] { PluginCreatorRegistry registry(manifestPath); }),
+          "a missing manifest throws");
+
+    if (g_failureCount != 0)
+    {
+        return 1;
+    }
+    std::cout << "All checks passed.\n";
+}
@@ -0,0 +1,215 @@
+// A benchmark of the GraphCloner of Prototype_Conceptual_Example.cpp, which clones a random graph of 10,000 nodes
+// with shared nodes and cycles into an arena, against cloning the same graph node by node with new, remapping
+// the nodes in a std::unordered_map and deleting the clone node by node. The example is compiled in, with its
+// main() renamed.
+//     g++ -std=c++20 -O2 Prototype_Benchmark.cpp -o Prototype_Benchmark
+//     ./Prototype_Benchmark [node count] [clone count]
+// The benchmark exits with a non-zero status if a clone doesn't have the shape of the original graph.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main prototypeExampleMain
+#include "Prototype_Conceptual_Example.cpp"
+#undef main
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+
+// The baseline: graph nodes that own their name and links, are cloned with new and deleted one by one.
+class HeapGraphNode
+{
+public:
+    std::string m_prototypeName;
+    float m_prototypeField;
+    std::vector<HeapGraphNode*> m_links;
+
+    HeapGraphNode(std::string prototypeName, const float prototypeField, const std::size_t linkCount)
+        : m_prototypeName(std::move(prototypeName))
+        , m_prototypeField(prototypeField)
+        , m_links(linkCount)
+    { }
+    virtual ~HeapGraphNode() = default;
+    virtual HeapGraphNode* clone() const = 0;
+};
+
+class ConcreteHeapGraphNode1 : public HeapGraphNode
+{
+public:
+    using HeapGraphNode::HeapGraphNode;
+    HeapGraphNode* clone() const override { return new ConcreteHeapGraphNode1(*this); }
+};
+
+class ConcreteHeapGraphNode2 : public HeapGraphNode
+{
+public:
+    using HeapGraphNode::HeapGraphNode;
+    HeapGraphNode* clone() const override { return new ConcreteHeapGraphNode2(*this); }
+};
+
+// Clones everything reachable from the roots, and returns the clones of the roots in the same order.
+std::vector<HeapGraphNode*> cloneOnHeap(const std::vector<HeapGraphNode*>& roots)
+{
+    std::unordered_map<const HeapGraphNode*, HeapGraphNode*> clones;
+    std::vector<HeapGraphNode*> unlinked;
+    const auto cloneOnce = [&clones, &unlinked](const HeapGraphNode* const node)
+    {
+        const auto [it, inserted] = clones.try_emplace(node, nullptr);
+        if (inserted)
+        {
+            it->second = node->clone();
+            unlinked.push_back(it->second);
+        }
+        return it->second;
+    };
+    std::vector<HeapGraphNode*> rootClones;
+    rootClones.reserve(roots.size());
+    for (const HeapGraphNode* const root : roots)
+    {
+        rootClones.push_back(cloneOnce(root));
+        while (!unlinked.empty())
+        {
+            HeapGraphNode* const clone = unlinked.back();
+            unlinked.pop_back();
+            for (HeapGraphNode*& link : clone->m_links)
+            {
+                link = cloneOnce(link);
+            }
+        }
+    }
+    return rootClones;
+}
+
+// Every node links to one to four random nodes, so many nodes are shared and the graph is full of cycles.
+struct Graphs
+{
+    PrototypeArena arena;
+    std::vector<GraphPrototype*> arenaNodes;
+    std::vector<HeapGraphNode*> heapNodes;
+    std::vector<std::vector<std::size_t>> links;
+
+    explicit Graphs(const std::size_t nodeCount)
+    {
+        std::mt19937 random(42);
+        std::uniform_int_distribution<std::size_t> linkCount(1, 4);
+        std::uniform_int_distribution<std::size_t> target(0, nodeCount - 1);
+        for (std::size_t i = 0; i < nodeCount; ++i)
+        {
+            const std::size_t count = linkCount(random);
+            links.emplace_back(count);
+            for (std::size_t& link : links.back())
+            {
+                link = target(random);
+            }
+            const std::string name = "NODE_" + std::to_string(i) + ' ';
+            const std::string_view arenaName = arena.copy(name);
+            const float field = static_cast<float>(i);
+            if (i % 2 == 0)
+            {
+                arenaNodes.push_back(arena.create<ConcreteGraphPrototype1>(arenaName, field, arena.createArray<GraphPrototype*>(count)));
+                heapNodes.push_back(new ConcreteHeapGraphNode1(name, field, count));
+            }
+            else
+            {
+                arenaNodes.push_back(arena.create<ConcreteGraphPrototype2>(arenaName, field, arena.createArray<GraphPrototype*>(count)));
+                heapNodes.push_back(new ConcreteHeapGraphNode2(name, field, count));
+            }
+        }
+        for (std::size_t i = 0; i < nodeCount; ++i)
+        {
+            for (std::size_t k = 0; k < links[i].size(); ++k)
+            {
+                arenaNodes[i]->link(k, arenaNodes[links[i][k]]);
+                heapNodes[i]->m_links[k] = heapNodes[links[i][k]];
+            }
+        }
+    }
+    ~Graphs()
+    {
+        for (const HeapGraphNode* const node : heapNodes)
+        {
+            delete node;
+        }
+    }
+
+    // The clones of the nodes, in the order of the nodes, must link like the nodes do and be new nodes.
+    template <typename Node, typename LinksOf>
+    bool isClone(const std::vector<Node*>& originals, const std::vector<Node*>& clones, LinksOf&& linksOf) const
+    {
+        for (std::size_t i = 0; i < links.size(); ++i)
+        {
+            const auto cloneLinks = linksOf(clones[i]);
+            if (clones[i] == originals[i] || cloneLinks.size() != links[i].size())
+            {
+                return false;
+            }
+            for (std::size_t k = 0; k < links[i].size(); ++k)
+            {
+                if (cloneLinks[k] != clones[links[i][k]])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    const std::size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000;
+    const std::size_t cloneCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+    const Graphs graphs(nodeCount);
+
+    // Every clone includes freeing it, which is where the arena saves the most.
+    bool cloned = true;
+    const auto arenaStart = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < cloneCount; ++i)
+    {
+        PrototypeArena arena;
+        GraphCloner cloner(arena, nodeCount);
+        std::vector<GraphPrototype*> clones;
+        clones.reserve(nodeCount);
+        for (const GraphPrototype* const node : graphs.arenaNodes)
+        {
+            clones.push_back(cloner.clone(*node));
+        }
+        if (i == 0)
+        {
+            cloned = cloned && graphs.isClone(graphs.arenaNodes, clones, [](const GraphPrototype* const node) { return node->links(); });
+        }
+        asm volatile("" : : "r"(clones.data()) : "memory");
+    }
+    const auto arenaEnd = std::chrono::steady_clock::now();
+
+    const auto heapStart = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < cloneCount; ++i)
+    {
+        const std::vector<HeapGraphNode*> clones = cloneOnHeap(graphs.heapNodes);
+        if (i == 0)
+        {
+            cloned = cloned && graphs.isClone(graphs.heapNodes, clones, [](const HeapGraphNode* const node) { return std::span(node->m_links); });
+        }
+        asm volatile("" : : "r"(clones.data()) : "memory");
+        for (const HeapGraphNode* const clone : clones)
+        {
+            delete clone;
+        }
+    }
+    const auto heapEnd = std::chrono::steady_clock::now();
+
+    if (!cloned)
+    {
+        std::cout << "FAILED: a clone doesn't have the shape of the original graph.\n";
+        return 1;
+    }
+    std::cout << nodeCount << "-node graph, " << cloneCount << " clones.\n";
+    std::cout << "cloner                        microseconds per clone\n";
+    for (const auto& [name, seconds] : { std::pair{ "arena + flat remapping      ", std::chrono::duration<double>(arenaEnd - arenaStart).count() },
+                                         std::pair{ "new + unordered_map + delete", std::chrono::duration<double>(heapEnd - heapStart).count() } })
+    {
+        std::cout << name << "  " << static_cast<std::uint64_t>(seconds * 1e6 / static_cast<double>(cloneCount)) << '\n';
+    }
+}
@@ -1,13 +1,54 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // Prototype Design Pattern
 // Intent: Lets you copy existing objects without making your code dependent on their classes.
 enum Type
 {
     PROTOTYPE_1 = 0,
-    PROTOTYPE_2 = 1
+    PROTOTYPE_2 = 1,
+    TYPE_COUNT
+};
+
+// The handle shares one value between all its copies and makes a private copy of the value only when it is
+// written to through this handle. Reading never copies.
+template <typename T>
+class CopyOnWrite
+{
+public:
+    explicit CopyOnWrite(T value)
+        : m_value(std::make_shared<T>(std::move(value)))
+    { }
+
+    const T& get() const { return *m_value; }
+    T& write()
+    {
+        if (m_value.use_count() > 1)
+        {
+            m_value = std::make_shared<T>(*m_value);
+        }
+        return *m_value;
+    }
+    // Replaces the value without copying the old one first.
+    void reset(T value) { m_value = std::make_shared<T>(std::move(value)); }
+    bool sharesWith(const CopyOnWrite& other) const { return m_value == other.m_value; }
+
+private:
+    std::shared_ptr<T> m_value;
 };
 
 // The example class that has cloning ability. We'll see how
@@ -15,7 +56,8 @@ enum Type
 class Prototype
 {
 protected:
-    std::string m_prototypeName;
+    // Clones rarely change their name, so they share it with their prototype until they do.
+    CopyOnWrite<std::string> m_prototypeName;
     float m_prototypeField;
 
 public:
@@ -25,16 +67,26 @@ public:
     { }
     virtual ~Prototype() = default;
     virtual Prototype* clone() const = 0;
+    // Clones into storage that the caller provides, which is at least cloneSize() bytes large and aligned
+    // to cloneAlignment(). The caller destroys the clone, but doesn't free it.
+    virtual Prototype* cloneInto(void* storage) const = 0;
+    virtual std::size_t cloneSize() const = 0;
+    virtual std::size_t cloneAlignment() const = 0;
     virtual void method(const float prototypeField)
     {
         m_prototypeField = prototypeField;
-        std::cout << "call method from " << m_prototypeName << " with field: " << m_prototypeField << '\n';
+        std::cout << "call method from " << m_prototypeName.get() << " with field: " << m_prototypeField << '\n';
     }
+    const std::string& name() const { return m_prototypeName.get(); }
+    void rename(std::string prototypeName) { m_prototypeName.reset(std::move(prototypeName)); }
+    void appendToName(const std::string_view suffix) { m_prototypeName.write() += suffix; }
+    bool sharesNameWith(const Prototype& other) const { return m_prototypeName.sharesWith(other.m_prototypeName); }
 };
 
-// ConcretePrototype1 is a sub-class of Prototype and implement the clone method. In this example all data members
-// of Prototype class are in the stack. If you have pointers in your properties for ex: std::string* m_name, you
-// will need to implement the copy-constructor to make sure you have a deep copy from the clone method.
+// ConcretePrototype1 is a sub-class of Prototype and implement the clone method. In this example the data members
+// of Prototype class are either values or copy-on-write handles, so the default copy-constructor is enough. If you
+// have raw pointers in your properties for ex: std::string* m_name, you will need to implement the copy-constructor
+// to make sure you have a deep copy from the clone method.
 class ConcretePrototype1 : public Prototype
 {
 public:
@@ -45,6 +97,9 @@ public:
     // Notice that clone method return a pointer to a new ConcretePrototype1 replica, so, the client
     // (who call the clone method) has the responsability to free that memory. You may prefer to use std::unique_ptr here.
     Prototype* clone() const override { return new ConcretePrototype1(*this); }
+    Prototype* cloneInto(void* const storage) const override { return new (storage) ConcretePrototype1(*this); }
+    std::size_t cloneSize() const override { return sizeof(ConcretePrototype1); }
+    std::size_t cloneAlignment() const override { return alignof(ConcretePrototype1); }
 };
 
 class ConcretePrototype2 : public Prototype
@@ -57,6 +112,311 @@ public:
     // Notice that clone method return a pointer to a new ConcretePrototype2 replica, so, the client
     // (who call the clone method) has the responsability to free that memory. You may prefer to use std::unique_ptr here.
     Prototype* clone() const override { return new ConcretePrototype2(*this); }
+    Prototype* cloneInto(void* const storage) const override { return new (storage) ConcretePrototype2(*this); }
+    std::size_t cloneSize() const override { return sizeof(ConcretePrototype2); }
+    std::size_t cloneAlignment() const override { return alignof(ConcretePrototype2); }
+};
+
+// The pool keeps many clones of the same prototype next to each other in a single allocation, instead of
+// allocating each clone separately. It destroys the clones and frees their memory when it is destroyed.
+class PrototypePool
+{
+public:
+    PrototypePool() = default;
+    explicit PrototypePool(const Prototype& prototype, const std::size_t count)
+        : m_stride(prototype.cloneSize())
+        , m_alignment(prototype.cloneAlignment())
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        if (count > std::numeric_limits<std::size_t>::max() / m_stride)
+        {
+            throw std::bad_array_new_length();
+        }
+        m_storage = static_cast<std::byte*>(::operator new(count * m_stride, std::align_val_t(m_alignment)));
+        try
+        {
+            for (; m_size < count; ++m_size)
+            {
+                std::byte* const slot = m_storage + m_size * m_stride;
+                m_baseOffset = reinterpret_cast<std::byte*>(prototype.cloneInto(slot)) - slot;
+            }
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+    PrototypePool(PrototypePool&& other) noexcept
+        : m_storage(std::exchange(other.m_storage, nullptr))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_stride(other.m_stride)
+        , m_alignment(other.m_alignment)
+        , m_baseOffset(other.m_baseOffset)
+    { }
+    PrototypePool& operator=(PrototypePool&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            m_storage = std::exchange(other.m_storage, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_stride = other.m_stride;
+            m_alignment = other.m_alignment;
+            m_baseOffset = other.m_baseOffset;
+        }
+        return *this;
+    }
+    ~PrototypePool() { clear(); }
+
+    std::size_t size() const { return m_size; }
+    Prototype& operator[](const std::size_t index)
+    {
+        return *std::launder(reinterpret_cast<Prototype*>(m_storage + index * m_stride + m_baseOffset));
+    }
+
+private:
+    std::byte* m_storage = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_stride = 0;
+    std::size_t m_alignment = alignof(std::max_align_t);
+    std::ptrdiff_t m_baseOffset = 0;
+
+    void clear()
+    {
+        if (m_storage == nullptr)
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < m_size; ++i)
+        {
+            (*this)[i].~Prototype();
+        }
+        ::operator delete(m_storage, std::align_val_t(m_alignment));
+        m_storage = nullptr;
+        m_size = 0;
+    }
+};
+
+// Real prototypes often own subobjects that point to each other, and a subobject may be shared by several others
+// or be part of a cycle. Cloning such a graph node by node with new is slow, and a naive deep copy duplicates the
+// shared subobjects and never ends on cycles. Here the whole graph is cloned into an arena: a remapping table from
+// the original nodes to their clones keeps the shared and cyclic links, and the clone is freed all at once.
+
+// The arena hands out memory from large chunks and frees them all together when it is destroyed, without
+// visiting the objects in them. That's why it only accepts trivially destructible objects.
+class PrototypeArena
+{
+public:
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    PrototypeArena() = default;
+    PrototypeArena(const PrototypeArena&) = delete;
+    PrototypeArena& operator=(const PrototypeArena&) = delete;
+
+    void* allocate(const std::size_t size, const std::size_t alignment)
+    {
+        void* pointer = m_cursor;
+        std::size_t space = static_cast<std::size_t>(m_end - m_cursor);
+        if (m_cursor == nullptr || std::align(alignment, size, pointer, space) == nullptr)
+        {
+            const std::size_t chunkSize = std::max(CHUNK_SIZE, size + alignment);
+            m_chunks.push_back(std::make_unique<std::byte[]>(chunkSize));
+            pointer = m_chunks.back().get();
+            space = chunkSize;
+            std::align(alignment, size, pointer, space);
+            m_end = m_chunks.back().get() + chunkSize;
+        }
+        m_cursor = static_cast<std::byte*>(pointer) + size;
+        return pointer;
+    }
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "The arena never destroys its objects");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+    template <typename T>
+    std::span<T> createArray(const std::size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "The arena never destroys its objects");
+        T* const array = static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        std::uninitialized_value_construct_n(array, count);
+        return std::span<T>(array, count);
+    }
+    std::string_view copy(const std::string_view text)
+    {
+        char* const chars = static_cast<char*>(allocate(text.size(), 1));
+        std::copy(text.begin(), text.end(), chars);
+        return std::string_view(chars, text.size());
+    }
+
+private:
+    std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+    std::byte* m_cursor = nullptr;
+    std::byte* m_end = nullptr;
+};
+
+class GraphCloner;
+
+// The graph prototypes keep all their state in their arena: the name and the links to other nodes point into it.
+// Unlike a Prototype, a node can't be cloned on its own onto the heap, since its clone would still link to the
+// nodes of the original graph. Each concrete class only clones itself into an arena, and the GraphCloner then
+// redirects the links of the clone.
+class GraphPrototype
+{
+    friend class GraphCloner;
+
+protected:
+    std::string_view m_prototypeName;
+    float m_prototypeField;
+    std::span<GraphPrototype*> m_links;
+
+    GraphPrototype(const GraphPrototype&) = default;
+    // The arena frees the nodes without destroying them, so they are never deleted through this class.
+    ~GraphPrototype() = default;
+
+    // Makes a shallow clone, whose links still point to the nodes of the original graph.
+    virtual GraphPrototype* cloneInto(PrototypeArena& arena) const = 0;
+
+public:
+    explicit GraphPrototype(const std::string_view prototypeName, const float prototypeField,
+                            const std::span<GraphPrototype*> links)
+        : m_prototypeName(prototypeName)
+        , m_prototypeField(prototypeField)
+        , m_links(links)
+    { }
+    GraphPrototype& operator=(const GraphPrototype&) = delete;
+
+    virtual void method(const float prototypeField)
+    {
+        m_prototypeField = prototypeField;
+        std::cout << "call method from " << m_prototypeName << " with field: " << m_prototypeField << '\n';
+    }
+    std::string_view name() const { return m_prototypeName; }
+    std::span<GraphPrototype* const> links() const { return m_links; }
+    void link(const std::size_t index, GraphPrototype* const node) { m_links[index] = node; }
+};
+
+class ConcreteGraphPrototype1 : public GraphPrototype
+{
+public:
+    using GraphPrototype::GraphPrototype;
+    ConcreteGraphPrototype1(const ConcreteGraphPrototype1&) = default;
+
+protected:
+    GraphPrototype* cloneInto(PrototypeArena& arena) const override
+    {
+        return arena.create<ConcreteGraphPrototype1>(*this);
+    }
+};
+
+class ConcreteGraphPrototype2 : public GraphPrototype
+{
+public:
+    using GraphPrototype::GraphPrototype;
+    ConcreteGraphPrototype2(const ConcreteGraphPrototype2&) = default;
+
+protected:
+    GraphPrototype* cloneInto(PrototypeArena& arena) const override
+    {
+        return arena.create<ConcreteGraphPrototype2>(*this);
+    }
+};
+
+// The cloner copies the graphs reachable from the nodes it is given into its arena. Every node is cloned only
+// once, and all the links to it are redirected to its only clone. The remapping table is a flat open addressing
+// table, which is sized for the expected number of nodes up front and doubles when it gets half full. The nodes are
+// visited from a worklist rather than recursively, so long chains of nodes don't overflow the stack.
+class GraphCloner
+{
+private:
+    struct Remapping
+    {
+        const GraphPrototype* original = nullptr;
+        GraphPrototype* clone = nullptr;
+    };
+
+    PrototypeArena& m_arena;
+    std::vector<Remapping> m_clones;
+    std::size_t m_cloneCount = 0;
+    std::vector<GraphPrototype*> m_unlinked;
+
+    // Fibonacci hashing of the node address, whose low bits are always zero.
+    static std::size_t slotOf(const GraphPrototype* const node, const std::size_t capacity)
+    {
+        const std::uint64_t hash = (reinterpret_cast<std::uintptr_t>(node) >> 4) * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(hash >> (64 - std::countr_zero(capacity)));
+    }
+    Remapping& find(const GraphPrototype* const node)
+    {
+        std::size_t slot = slotOf(node, m_clones.size());
+        while (m_clones[slot].original != nullptr && m_clones[slot].original != node)
+        {
+            slot = (slot + 1) & (m_clones.size() - 1);
+        }
+        return m_clones[slot];
+    }
+    void grow()
+    {
+        std::vector<Remapping> clones(m_clones.size() * 2);
+        clones.swap(m_clones);
+        for (const Remapping& remapping : clones)
+        {
+            if (remapping.original != nullptr)
+            {
+                find(remapping.original) = remapping;
+            }
+        }
+    }
+    GraphPrototype* cloneOnce(const GraphPrototype* const node)
+    {
+        Remapping* remapping = &find(node);
+        if (remapping->original == nullptr)
+        {
+            if (2 * (m_cloneCount + 1) > m_clones.size())
+            {
+                grow();
+                remapping = &find(node);
+            }
+            GraphPrototype* const clone = node->cloneInto(m_arena);
+            clone->m_prototypeName = m_arena.copy(node->m_prototypeName);
+            *remapping = Remapping{ node, clone };
+            ++m_cloneCount;
+            m_unlinked.push_back(clone);
+        }
+        return remapping->clone;
+    }
+
+public:
+    explicit GraphCloner(PrototypeArena& arena, const std::size_t expectedNodeCount = 64)
+        : m_arena(arena)
+        , m_clones(std::bit_ceil(2 * std::max<std::size_t>(expectedNodeCount, 1)))
+    {
+        m_unlinked.reserve(expectedNodeCount);
+    }
+
+    // Cloning more nodes with the same cloner reuses the clones of the nodes they share with the earlier ones.
+    GraphPrototype* clone(const GraphPrototype& root)
+    {
+        GraphPrototype* const rootClone = cloneOnce(&root);
+        while (!m_unlinked.empty())
+        {
+            GraphPrototype* const clone = m_unlinked.back();
+            m_unlinked.pop_back();
+            // The shallow clone still shares its links with the original node.
+            const std::span<GraphPrototype*> originalLinks = clone->m_links;
+            clone->m_links = m_arena.createArray<GraphPrototype*>(originalLinks.size());
+            for (std::size_t i = 0; i < originalLinks.size(); ++i)
+            {
+                clone->m_links[i] = originalLinks[i] != nullptr ? cloneOnce(originalLinks[i]) : nullptr;
+            }
+        }
+        return rootClone;
+    }
 };
 
 // In PrototypeFactory you have two concrete prototypes, one for each concrete prototype class,
@@ -64,7 +424,8 @@ public:
 class PrototypeFactory
 {
 private:
-    std::unordered_map<Type, Prototype*> m_prototypes;
+    // The types are small and dense, so the prototypes are simply indexed by their type.
+    std::array<Prototype*, Type::TYPE_COUNT> m_prototypes;
 
 public:
     explicit PrototypeFactory()
@@ -81,10 +442,21 @@ public:
 
     // Notice here that you just need to specify the type of the prototype you
     // want and the method will create from the object with this type.
-    Prototype* createPrototype(const Type type) { return m_prototypes[type]->clone(); }
+    Prototype* createPrototype(const Type type) const
+    {
+        assert(type < Type::TYPE_COUNT);
+        return m_prototypes[type]->clone();
+    }
+    // Creates many clones of the prototype at once, with a single allocation for all of them.
+    PrototypePool createPrototypes(const Type type, const std::size_t count) const
+    {
+        assert(type < Type::TYPE_COUNT);
+        return PrototypePool(*m_prototypes[type], count);
+    }
 };
 
-void client(PrototypeFactory& prototypeFactory)
+// Returns false if the clones of Prototype 2 didn't keep their names apart.
+bool client(PrototypeFactory& prototypeFactory)
 {
     std::cout << "Let's create a Prototype 1\n";
     Prototype* prototype = prototypeFactory.createPrototype(Type::PROTOTYPE_1);
@@ -95,11 +467,81 @@ void client(PrototypeFactory& prototypeFactory)
     prototype = prototypeFactory.createPrototype(Type::PROTOTYPE_2);
     prototype->method(10);
     delete prototype;
+
+    std::cout << "\nLet's create three Prototypes 1 at once\n";
+    PrototypePool pool = prototypeFactory.createPrototypes(Type::PROTOTYPE_1, 3);
+    for (std::size_t i = 0; i < pool.size(); ++i)
+    {
+        pool[i].method(static_cast<float>(i));
+    }
+
+    std::cout << "\nLet's change the names of clones of Prototype 2\n";
+    Prototype* const original = prototypeFactory.createPrototype(Type::PROTOTYPE_2);
+    Prototype* const renamed = original->clone();
+    const bool sharedBeforeWrite = original->sharesNameWith(*renamed);
+    std::cout << "The clones share their name: " << std::boolalpha << sharedBeforeWrite << '\n';
+    Prototype* const extended = original->clone();
+    renamed->rename("RENAMED_2 ");
+    extended->appendToName("(extended) ");
+    const bool sharedAfterWrite = original->sharesNameWith(*renamed) || original->sharesNameWith(*extended);
+    std::cout << "The clones share their name: " << original->sharesNameWith(*renamed) << ' '
+              << original->sharesNameWith(*extended) << '\n';
+    const bool isolated = sharedBeforeWrite && !sharedAfterWrite && original->name() == "PROTOTYPE_2 "
+        && renamed->name() == "RENAMED_2 " && extended->name() == "PROTOTYPE_2 (extended) ";
+    original->method(20);
+    renamed->method(30);
+    extended->method(40);
+    delete extended;
+    delete renamed;
+    delete original;
+    if (!isolated)
+    {
+        std::cout << "FAILED: writing to the name of a clone changed another clone.\n";
+    }
+    return isolated;
+}
+
+// The client code builds a small graph, in which node A links twice to node B and node B links back to node A,
+// and clones it. The clone has the same shape, but shares no node with the original. Returns false if it doesn't.
+bool graphClient()
+{
+    std::cout << "\nLet's clone a graph of prototypes\n";
+    PrototypeArena prototypes;
+    GraphPrototype* const nodeA =
+        prototypes.create<ConcreteGraphPrototype1>("NODE_A ", 1.f, prototypes.createArray<GraphPrototype*>(2));
+    GraphPrototype* const nodeB =
+        prototypes.create<ConcreteGraphPrototype2>("NODE_B ", 2.f, prototypes.createArray<GraphPrototype*>(1));
+    nodeA->link(0, nodeB);
+    nodeA->link(1, nodeB);
+    nodeB->link(0, nodeA);
+
+    PrototypeArena clones;
+    GraphCloner cloner(clones, 2);
+    GraphPrototype* const cloneA = cloner.clone(*nodeA);
+    GraphPrototype* const cloneB = cloneA->links()[0];
+    const bool isNewGraph = cloneA != nodeA && cloneB != nodeB;
+    const bool keepsSharing = cloneA->links()[1] == cloneB;
+    const bool keepsCycle = cloneB->links()[0] == cloneA;
+    const bool copiesNames = cloneA->name() == nodeA->name() && cloneA->name().data() != nodeA->name().data();
+    std::cout << std::boolalpha << "The clone is a new graph: " << isNewGraph << '\n'
+              << "The shared node is still shared: " << keepsSharing << '\n'
+              << "The cycle is still a cycle: " << keepsCycle << '\n'
+              << "The clone has its own copy of the name: " << copiesNames << '\n';
+    cloneA->method(10);
+    nodeA->method(20);
+    const bool cloned = isNewGraph && keepsSharing && keepsCycle && copiesNames;
+    if (!cloned)
+    {
+        std::cout << "FAILED: the clone doesn't have the shape of the original graph.\n";
+    }
+    return cloned;
 }
 
 int main()
 {
     PrototypeFactory* const prototypeFactory = new PrototypeFactory();
-    client(*prototypeFactory);
+    const bool clonesIsolated = client(*prototypeFactory);
+    const bool graphCloned = graphClient();
     delete prototypeFactory;
+    return clonesIsolated && graphCloned ? 0 : 1;
 }